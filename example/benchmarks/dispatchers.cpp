@@ -0,0 +1,136 @@
+// Latency of requests on fresh connections, so every request is
+// handed from accepting thread to Worker by Dispatcher. Each one
+// is run in its own process (Router is singleton), without and with
+// slow requests among fast ones.
+#include <rest/server.h>
+#include <rest/lambda_service.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int WORKERS = 4;
+static const int STREAMERS = 1;
+static const int CLIENTS = 8;
+static const int REQUESTS = 1000;
+//! every SLOW_EVERY-th request of mixed load takes SLOW_TIME microseconds
+static const int SLOW_EVERY = 10;
+static const int SLOW_TIME = 2000;
+
+//! connects, sends request and reads response until server closes connection
+static bool request(std::string const& path, const char* uri) {
+  int handle = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  if (connect(handle, (struct sockaddr *)&address, sizeof(address)) == -1) {
+    close(handle);
+    return false;
+  }
+
+  // HTTP/1.0 connection is closed after response
+  std::string head = std::string("GET ") + uri + " HTTP/1.0\r\n\r\n";
+  bool sent = write(handle, head.data(), head.size()) == (ssize_t) head.size();
+
+  char buffer[4096];
+  ssize_t length;
+  size_t total = 0;
+  while ((length = read(handle, buffer, sizeof(buffer))) > 0)
+    total += length;
+
+  close(handle);
+  return sent && total > 0;
+}
+
+static void measure(std::string const& path, bool mixed, const char* name) {
+  std::vector< std::vector<double> > latencies(CLIENTS);
+  std::vector<std::thread> clients;
+
+  for (int c = 0; c < CLIENTS; c++)
+    clients.emplace_back([&path, &latencies, mixed, c] () {
+      for (int i = 0; i < REQUESTS; i++) {
+        bool slow = mixed && (i + c) % SLOW_EVERY == 0;
+        auto start = std::chrono::steady_clock::now();
+        request(path, slow ? "/slow" : "/fast");
+
+        // only fast requests are measured, slow ones are the load
+        if (!slow)
+          latencies[c].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+      }
+    });
+
+  for (auto& client : clients)
+    client.join();
+
+  std::vector<double> all;
+  for (auto const& client : latencies)
+    all.insert(all.end(), client.begin(), client.end());
+  std::sort(all.begin(), all.end());
+
+  double sum = 0;
+  for (double latency : all)
+    sum += latency;
+
+  printf("%-18s %-6s mean %8.1f us   p50 %8.1f us   p99 %8.1f us   p99.9 %8.1f us\n", name, mixed ? "mixed" : "fast",
+    sum / all.size(), all[all.size() / 2], all[all.size() * 99 / 100], all[all.size() * 999 / 1000]);
+  fflush(stdout);
+}
+
+template <class D>
+static void run(const char* name) {
+  pid_t child = fork();
+  if (child != 0) {
+    waitpid(child, nullptr, 0);
+    return;
+  }
+
+  std::string path = "/tmp/rest-cpp-bench-" + std::to_string(getpid()) + ".sock";
+  REST::Server* server = new REST::Server(path, new D(WORKERS, STREAMERS));
+
+  server->router()->match("/fast", [] (REST::LambdaService* s) {
+    s->response->raw = "fast";
+  });
+  server->router()->match("/slow", [] (REST::LambdaService* s) {
+    usleep(SLOW_TIME);
+    s->response->raw = "slow";
+  });
+
+  // routes are printed when server starts
+  std::cout.setstate(std::ios::failbit);
+  std::thread([server] () { server->run(); }).detach();
+
+  while (!request(path, "/fast"))
+    usleep(1000);
+
+  measure(path, false, name);
+  measure(path, true, name);
+
+  unlink(path.c_str());
+  _exit(0);
+}
+
+int main() {
+  printf("%d workers, %d clients, %d requests each, connection per request\n", WORKERS, CLIENTS, REQUESTS);
+  // children would print buffered output again
+  fflush(stdout);
+
+  run<REST::Dispatchers::RoundRobin>("RoundRobin");
+  run<REST::Dispatchers::LeastConnections>("LeastConnections");
+  run<REST::Dispatchers::Uniform>("Uniform");
+  run<REST::Dispatchers::LeastLatency>("LeastLatency");
+  run<REST::Dispatchers::PowerOfTwo>("PowerOfTwo");
+  run<REST::Dispatchers::WorkStealing>("WorkStealing");
+
+  return 0;
+}
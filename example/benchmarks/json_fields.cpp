@@ -0,0 +1,120 @@
+// Reads and writes the same documents through structs bound with
+// REST_JSON_FIELDS and through Json::Value, as handlers would.
+#include <rest/json_fields.h>
+#include <rest/json_writer.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+struct Tag {
+  std::string name;
+  int weight;
+};
+
+REST_JSON_FIELDS(Tag, name, weight)
+
+struct Task {
+  int64_t id;
+  std::string title;
+  bool done;
+  double progress;
+  std::vector<Tag> tags;
+};
+
+REST_JSON_FIELDS(Task, id, title, done, progress, tags)
+
+static const int TASKS = 1000;
+static const int ROUNDS = 200;
+
+//! best time of `ROUNDS` runs of `body`, in microseconds
+static double measure(std::function<void()> const& body) {
+  double best = 0;
+  for (int i = 0; i < ROUNDS; i++) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    double took = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    if (i == 0 || took < best)
+      best = took;
+  }
+  return best;
+}
+
+static void report(const char* name, double bound, double value, size_t bytes) {
+  printf("%-6s bound %9.1f us (%6.1f MB/s)   Json::Value %9.1f us (%6.1f MB/s)   %.2fx\n",
+    name, bound, bytes / bound, value, bytes / value, value / bound);
+}
+
+int main() {
+  std::vector<Task> tasks(TASKS);
+  for (int i = 0; i < TASKS; i++) {
+    tasks[i].id = 1000000 + i;
+    tasks[i].title = "Task number " + std::to_string(i) + " with \"quoted\" title";
+    tasks[i].done = i % 3 == 0;
+    tasks[i].progress = i / 7.0;
+    tasks[i].tags = { { "home", i % 5 }, { "work", i % 11 } };
+  }
+
+  std::string document;
+  REST::JsonFields::write(tasks, document);
+
+  REST::Arena arena;
+  size_t checksum = 0;
+
+  double write_bound = measure([&] () {
+    std::string output;
+    REST::JsonFields::write(tasks, output);
+    checksum += output.size();
+  });
+
+  double write_value = measure([&] () {
+    REST::Arena::Scope scope(&arena);
+    Json::Value root(Json::arrayValue);
+    for (auto const& task : tasks) {
+      Json::Value& item = root.append(Json::Value(Json::objectValue));
+      item["id"] = static_cast<Json::Int64>(task.id);
+      item["title"] = task.title;
+      item["done"] = task.done;
+      item["progress"] = task.progress;
+      Json::Value& tags = item["tags"] = Json::Value(Json::arrayValue);
+      for (auto const& tag : task.tags) {
+        Json::Value& entry = tags.append(Json::Value(Json::objectValue));
+        entry["name"] = tag.name;
+        entry["weight"] = tag.weight;
+      }
+    }
+    std::string output;
+    REST::JsonWriter::write(root, output);
+    checksum += output.size();
+  });
+
+  double read_bound = measure([&] () {
+    REST::JsonDocument data;
+    data.reset(document.data(), document.size(), &arena);
+    std::vector<Task> read;
+    REST::JsonFields::read(data.root(), read);
+    checksum += read.size();
+  });
+
+  double read_value = measure([&] () {
+    REST::JsonDocument data;
+    data.reset(document.data(), document.size(), &arena);
+    std::vector<Task> read(data.size());
+    for (Json::ArrayIndex i = 0; i < read.size(); i++) {
+      Json::Value const& item = data[i];
+      read[i].id = item["id"].asInt64();
+      read[i].title = item["title"].asString();
+      read[i].done = item["done"].asBool();
+      read[i].progress = item["progress"].asDouble();
+      for (auto const& tag : item["tags"])
+        read[i].tags.push_back({ tag["name"].asString(), tag["weight"].asInt() });
+    }
+    checksum += read.size();
+  });
+
+  printf("%d tasks, %zu bytes of JSON, best of %d rounds\n", TASKS, document.size(), ROUNDS);
+  report("write", write_bound, write_value, document.size());
+  report("read", read_bound, read_value, document.size());
+
+  return checksum == 0;
+}
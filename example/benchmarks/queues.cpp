@@ -0,0 +1,123 @@
+// Push-to-pop latency of handing clients to Worker: lock-free Ring,
+// whose consumer is woken up through Poller only when it sleeps, and
+// std::queue guarded by mutex and condition_variable, which Workers
+// used before.
+#include <rest/ring.h>
+#include <rest/poller.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+static const int ITEMS = 20000;
+//! pause between pushes of paced run, consumer falls asleep meanwhile
+static const int PAUSE = 20;
+
+static int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//! what Workers did before - lock, push and notify for every client
+class LockedQueue {
+  public:
+    void push(int64_t stamp) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.push(stamp);
+      }
+      ready.notify_one();
+    }
+
+    void consume(std::vector<int64_t>& latencies) {
+      while (latencies.size() < ITEMS) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] () { return !items.empty(); });
+        while (!items.empty()) {
+          latencies.push_back(now() - items.front());
+          items.pop();
+        }
+      }
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::queue<int64_t> items;
+};
+
+//! same hand-off as Dispatcher::dispatch() and Worker::run()
+class RingQueue {
+  public:
+    RingQueue() : items(1024), sleeping(false) {}
+
+    void push(int64_t stamp) {
+      while (!items.push(stamp))
+        std::this_thread::yield();
+
+      if (sleeping.exchange(false))
+        poller.wake();
+    }
+
+    void consume(std::vector<int64_t>& latencies) {
+      while (latencies.size() < ITEMS) {
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int count = poller.wait(items.empty() ? -1 : 0);
+        sleeping.store(false, std::memory_order_relaxed);
+
+        for (int i = 0; i < count; i++)
+          if (poller.event(i).tag == nullptr)
+            poller.drain();
+
+        int64_t stamp;
+        while (items.pop(stamp))
+          latencies.push_back(now() - stamp);
+      }
+    }
+
+  private:
+    REST::Ring<int64_t> items;
+    std::atomic<bool> sleeping;
+    REST::Poller poller;
+};
+
+template <class Queue>
+static void measure(const char* name, bool paced) {
+  Queue queue;
+  std::vector<int64_t> latencies;
+  latencies.reserve(ITEMS);
+
+  std::thread consumer([&queue, &latencies] () { queue.consume(latencies); });
+
+  int64_t start = now();
+  for (int i = 0; i < ITEMS; i++) {
+    queue.push(now());
+    if (paced)
+      std::this_thread::sleep_for(std::chrono::microseconds(PAUSE));
+  }
+  consumer.join();
+  double took = (now() - start) / 1e9;
+
+  std::sort(latencies.begin(), latencies.end());
+  printf("%-13s %-6s p50 %8.2f us   p99 %8.2f us   p99.9 %8.2f us   %10.0f items/s\n", name, paced ? "paced" : "burst",
+    latencies[ITEMS / 2] / 1e3, latencies[ITEMS * 99 / 100] / 1e3, latencies[ITEMS * 999 / 1000] / 1e3, ITEMS / took);
+}
+
+int main() {
+  printf("%d items, paced run pauses %d us between pushes\n", ITEMS, PAUSE);
+
+  measure<LockedQueue>("mutex+condvar", true);
+  measure<RingQueue>("Ring+nudge", true);
+  measure<LockedQueue>("mutex+condvar", false);
+  measure<RingQueue>("Ring+nudge", false);
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "arena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace REST {
+
+thread_local Arena* Arena::active = nullptr;
+
+Arena::Scope::Scope(Arena* arena) : previous(active) {
+  active = arena;
+}
+
+Arena::Scope::~Scope() {
+  active = previous;
+}
+
+Arena::Arena(size_t size) : chunk_size(size) {
+  current = make_chunk();
+}
+
+Arena::~Arena() {
+  // blocks still in use keep their chunk
+  unreference(current);
+}
+
+Arena::Chunk* Arena::make_chunk() {
+  Chunk* chunk = static_cast<Chunk*>(malloc(sizeof(Chunk) + chunk_size));
+  if (chunk == nullptr)
+    throw std::bad_alloc();
+
+  chunk->references.store(1, std::memory_order_relaxed);
+  chunk->used = 0;
+  chunk->capacity = chunk_size;
+  return chunk;
+}
+
+void* Arena::allocate(size_t size) {
+  size_t total = sizeof(Block) + ((size + 15) & ~size_t(15));
+
+  if (total > chunk_size / 4)
+    return allocate_heap(size);
+
+  if (current->references.load(std::memory_order_acquire) == 1) {
+    // everything was released, start over
+    current->used = 0;
+  } else
+  if (current->used + total > current->capacity) {
+    unreference(current);
+    current = make_chunk();
+  }
+
+  Block* block = reinterpret_cast<Block*>(reinterpret_cast<char*>(current + 1) + current->used);
+  block->chunk = current;
+
+  current->used += total;
+  current->references.fetch_add(1, std::memory_order_relaxed);
+
+  return block + 1;
+}
+
+void* Arena::allocate_current(size_t size) {
+  return active ? active->allocate(size) : allocate_heap(size);
+}
+
+void* Arena::allocate_heap(size_t size) {
+  Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+  if (block == nullptr)
+    throw std::bad_alloc();
+
+  block->chunk = nullptr;
+  return block + 1;
+}
+
+void Arena::release(void* pointer) {
+  if (pointer == nullptr)
+    return;
+
+  Block* block = static_cast<Block*>(pointer) - 1;
+
+  if (block->chunk == nullptr)
+    free(block);
+  else
+    unreference(block->chunk);
+}
+
+void Arena::unreference(Chunk* chunk) {
+  if (chunk->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    free(chunk);
+}
+
+}
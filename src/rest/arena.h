@@ -0,0 +1,118 @@
+#ifndef REST_CPP_ARENA_H
+#define REST_CPP_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace REST {
+
+/**
+ * Arena is bump-pointer allocator owned by single Worker. Memory
+ * is taken from big chunks, every chunk counts blocks allocated
+ * from it and is given back when all of them are released.
+ * When everything allocated while handling request is released
+ * (as it usually is, once request is handled), Worker starts
+ * again from beginning of the same chunk, so each request reuses
+ * memory of previous one.
+ *
+ * Only owning thread allocates, blocks may be released by any
+ * thread and may outlive Arena itself. Blocks bigger than quarter
+ * of chunk are taken from heap.
+ *
+ * @private
+ * @see Worker
+ */
+class Arena final {
+
+  public:
+    /**
+     * Standard allocator, which allocates from given Arena (or
+     * from heap if there is none).
+     */
+    template <class T>
+    class Allocator {
+      public:
+        typedef T value_type;
+
+        Allocator(Arena* a = nullptr) : arena(a) {}
+        template <class U>
+        Allocator(Allocator<U> const& other) : arena(other.arena) {}
+
+        T* allocate(size_t n) {
+          return static_cast<T*>(arena ? arena->allocate(n * sizeof(T)) : Arena::allocate_heap(n * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t) {
+          Arena::release(pointer);
+        }
+
+        template <class U>
+        bool operator==(Allocator<U> const& other) const { return arena == other.arena; }
+        template <class U>
+        bool operator!=(Allocator<U> const& other) const { return arena != other.arena; }
+
+        Arena* arena;
+    };
+
+    /**
+     * Makes Arena current one for this thread while Scope exists,
+     * see allocate_current().
+     */
+    class Scope {
+      public:
+        Scope(Arena* arena);
+        ~Scope();
+
+      private:
+        Arena* previous;
+    };
+
+    Arena(size_t chunk_size = CHUNK_SIZE);
+    ~Arena();
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    void* allocate(size_t size);
+
+    //! shared_ptr to object created in memory from allocate(), its control block is in Arena too
+    template <class T>
+    std::shared_ptr<T> share(T* object) {
+      return std::shared_ptr<T>(object, [] (T* o) { o->~T(); Arena::release(o); }, Allocator<T>(this));
+    }
+
+    //! allocates from Arena of current Scope, or from heap if there is none
+    static void* allocate_current(size_t size);
+    static void* allocate_heap(size_t size);
+    //! releases block of any Arena (or heap block taken by Arena)
+    static void release(void* pointer);
+
+    const static size_t CHUNK_SIZE = 64 * 1024;
+
+  private:
+    struct alignas(16) Chunk {
+      //! allocated blocks, plus one while Chunk is used by Arena
+      std::atomic<size_t> references;
+      size_t used;
+      size_t capacity;
+    };
+
+    //! precedes every block, keeps alignment of 16
+    struct Block {
+      Chunk* chunk;
+      size_t reserved;
+    };
+
+    Chunk* make_chunk();
+    static void unreference(Chunk* chunk);
+
+    Chunk* current;
+    size_t chunk_size;
+
+    static thread_local Arena* active;
+};
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "body_format.h"
+#include "header.h"
+#include "message_pack.h"
+#include "cbor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace REST {
+
+const size_t BodyFormat::MAX_DEPTH;
+
+static const struct {
+  BodyFormat::Type type;
+  StringView name;
+} MEDIA_TYPES[] = {
+  { BodyFormat::MSGPACK, "application/msgpack" },
+  { BodyFormat::MSGPACK, "application/x-msgpack" },
+  { BodyFormat::MSGPACK, "application/vnd.msgpack" },
+  { BodyFormat::CBOR, "application/cbor" }
+};
+
+static StringView trim(const char* begin, const char* end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
+  return StringView(begin, end - begin);
+}
+
+BodyFormat::Type BodyFormat::negotiate(StringView const& accept) {
+  // weight of JSON and how specific range which gave it was
+  // (0 for */*, 1 for application/*, 2 for application/json)
+  double json = -1;
+  int json_specificity = -1;
+
+  Type best = JSON;
+  double best_weight = 0;
+
+  const char* position = accept.begin();
+
+  while (position < accept.end()) {
+    const char* next = static_cast<const char*>(memchr(position, ',', accept.end() - position));
+    if (next == nullptr)
+      next = accept.end();
+
+    const char* semicolon = static_cast<const char*>(memchr(position, ';', next - position));
+    StringView range = trim(position, semicolon != nullptr ? semicolon : next);
+    double q = 1;
+
+    // weight is q parameter, which may follow other ones
+    for (const char* parameter = semicolon; parameter != nullptr && parameter < next; ) {
+      const char* end = static_cast<const char*>(memchr(parameter + 1, ';', next - parameter - 1));
+      StringView value = trim(parameter + 1, end != nullptr ? end : next);
+      if (value.starts_with("q="))
+        q = strtod(std::string(value.data() + 2, value.size() - 2).c_str(), nullptr);
+      parameter = end;
+    }
+
+    int specificity = Header::equals(range, "application/json") ? 2 :
+      Header::equals(range, "application/*") ? 1 :
+      range == "*/*" ? 0 : -1;
+    if (specificity > json_specificity) {
+      json = q;
+      json_specificity = specificity;
+    }
+
+    for (auto const& media_type : MEDIA_TYPES)
+      if (q > best_weight && Header::equals(range, media_type.name)) {
+        best = media_type.type;
+        best_weight = q;
+      }
+
+    position = next + 1;
+  }
+
+  // on equal weights, JSON wins only when client names it
+  if (best != JSON && (best_weight > json || (best_weight == json && json_specificity < 2)))
+    return best;
+  return JSON;
+}
+
+bool BodyFormat::of(StringView const& content_type, Type& type) {
+  if (content_type.starts_with("application/json") || content_type.starts_with("text/json")) {
+    type = JSON;
+    return true;
+  }
+
+  for (auto const& media_type : MEDIA_TYPES)
+    if (content_type.starts_with(media_type.name)) {
+      type = media_type.type;
+      return true;
+    }
+
+  return false;
+}
+
+StringView BodyFormat::content_type(Type type) {
+  switch (type) {
+    case MSGPACK: return "application/msgpack";
+    case CBOR: return "application/cbor";
+    default: return "application/json; charset=utf-8";
+  }
+}
+
+void BodyFormat::write(Type type, Json::Value const& value, std::string& output) {
+  if (type == MSGPACK)
+    MessagePack::write(value, output);
+  else if (type == CBOR)
+    Cbor::write(value, output);
+}
+
+bool BodyFormat::read(Type type, const char* data, size_t size, Json::Value& value) {
+  if (type == MSGPACK)
+    return MessagePack::read(data, size, value);
+  if (type == CBOR)
+    return Cbor::read(data, size, value);
+  return false;
+}
+
+void BodyFormat::put(std::string& output, uint8_t type, uint64_t value, int bytes) {
+  char buffer[9];
+  buffer[0] = static_cast<char>(type);
+  for (int i = 0; i < bytes; i++)
+    buffer[1 + i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+  output.append(buffer, 1 + bytes);
+}
+
+bool BodyFormat::take(const unsigned char*& p, const unsigned char* end, int bytes, uint64_t& value) {
+  if (end - p < bytes)
+    return false;
+
+  value = 0;
+  for (int i = 0; i < bytes; i++)
+    value = (value << 8) | *p++;
+  return true;
+}
+
+Json::Value BodyFormat::integer(uint64_t magnitude, bool negative) {
+  if (!negative) {
+    if (magnitude <= static_cast<uint64_t>(Json::Value::maxInt))
+      return Json::Value(static_cast<Json::LargestInt>(magnitude));
+    return Json::Value(static_cast<Json::LargestUInt>(magnitude));
+  }
+
+  if (magnitude <= static_cast<uint64_t>(Json::Value::maxLargestInt) + 1)
+    return Json::Value(static_cast<Json::LargestInt>(0 - magnitude));
+  return Json::Value(-static_cast<double>(magnitude));
+}
+
+void BodyFormat::assign(Json::Value& object, Members& members) {
+  // members are inserted in key order, so each of them is appended,
+  // stable sort keeps duplicates in order they came
+  auto less = [] (Members::value_type const& a, Members::value_type const& b) { return a.first < b.first; };
+  if (!std::is_sorted(members.begin(), members.end(), less))
+    std::stable_sort(members.begin(), members.end(), less);
+
+  object = Json::Value(Json::objectValue);
+  for (auto& member : members)
+    object[member.first].swap(member.second);
+
+  members.clear();
+}
+
+}
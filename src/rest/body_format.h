@@ -0,0 +1,61 @@
+#ifndef REST_CPP_BODY_FORMAT_H
+#define REST_CPP_BODY_FORMAT_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "string_view.h"
+#include "json/json.h"
+
+namespace REST {
+
+/**
+ * BodyFormat is encoding of structured body - Request::data and
+ * Response::data. JSON is used unless client asks for MessagePack
+ * or CBOR, which carry the same values in fewer bytes and are
+ * encoded and decoded without formatting or parsing numbers.
+ *
+ * Binary formats are used only when client names them in Accept
+ * (application/msgpack, application/x-msgpack,
+ * application/vnd.msgpack or application/cbor) with weight higher
+ * than JSON has, or equal to weight of wildcard JSON matches.
+ *
+ * @private
+ * @see Response
+ * @see JsonDocument
+ */
+class BodyFormat final {
+
+  public:
+    enum Type { JSON, MSGPACK, CBOR };
+
+    typedef std::vector< std::pair<std::string, Json::Value> > Members;
+
+    const static size_t MAX_DEPTH = 1000;
+
+    //! format client prefers, JSON if it does not ask for other one
+    static Type negotiate(StringView const& accept);
+    //! format of body of given Content-Type, false if it is not structured one
+    static bool of(StringView const& content_type, Type& type);
+    static StringView content_type(Type type);
+
+    //! appends `value` encoded in binary `type` to `output`
+    static void write(Type type, Json::Value const& value, std::string& output);
+    //! decodes single value of binary `type`, false if it is not valid
+    static bool read(Type type, const char* data, size_t size, Json::Value& value);
+
+    //! appends `type` followed by `bytes` bytes of `value`, big endian
+    static void put(std::string& output, uint8_t type, uint64_t value, int bytes);
+    //! reads `bytes` bytes big endian number, false if there is not enough of them
+    static bool take(const unsigned char*& p, const unsigned char* end, int bytes, uint64_t& value);
+    //! integer of the same type Json::Reader would give, double if it does not fit
+    static Json::Value integer(uint64_t magnitude, bool negative);
+    //! makes object of `members` (emptied), last of duplicate keys wins
+    static void assign(Json::Value& object, Members& members);
+};
+
+}
+
+#endif
@@ -0,0 +1,301 @@
+#include "cbor.h"
+#include "body_format.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace REST {
+
+// major types
+static const uint8_t UNSIGNED_INTEGER = 0;
+static const uint8_t NEGATIVE_INTEGER = 1;
+static const uint8_t BYTE_STRING = 2;
+static const uint8_t TEXT_STRING = 3;
+static const uint8_t ARRAY = 4;
+static const uint8_t MAP = 5;
+static const uint8_t TAG = 6;
+
+// initial bytes of simple values and floats
+static const uint8_t FALSE_VALUE = 0xf4;
+static const uint8_t TRUE_VALUE = 0xf5;
+static const uint8_t NULL_VALUE = 0xf6;
+static const uint8_t UNDEFINED_VALUE = 0xf7;
+static const uint8_t HALF_FLOAT = 0xf9;
+static const uint8_t SINGLE_FLOAT = 0xfa;
+static const uint8_t DOUBLE_FLOAT = 0xfb;
+static const uint8_t BREAK = 0xff;
+//! additional information of indefinite length item
+static const uint8_t INDEFINITE = 31;
+
+//! initial byte of `major` type followed by its argument
+static void write_head(uint8_t major, uint64_t value, std::string& output) {
+  uint8_t type = major << 5;
+
+  if (value < 24)
+    output += static_cast<char>(type | value);
+  else if (value <= UINT8_MAX)
+    BodyFormat::put(output, type | 24, value, 1);
+  else if (value <= UINT16_MAX)
+    BodyFormat::put(output, type | 25, value, 2);
+  else if (value <= UINT32_MAX)
+    BodyFormat::put(output, type | 26, value, 4);
+  else
+    BodyFormat::put(output, type | 27, value, 8);
+}
+
+static void write_double(double value, std::string& output) {
+  float single = static_cast<float>(value);
+
+  if (std::fabs(value) <= FLT_MAX && static_cast<double>(single) == value) {
+    uint32_t bits;
+    memcpy(&bits, &single, sizeof(bits));
+    BodyFormat::put(output, SINGLE_FLOAT, bits, 4);
+  } else {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    BodyFormat::put(output, DOUBLE_FLOAT, bits, 8);
+  }
+}
+
+void Cbor::write(Json::Value const& value, std::string& output) {
+  switch (value.type()) {
+    case Json::nullValue:
+      output += static_cast<char>(NULL_VALUE);
+      break;
+
+    case Json::booleanValue:
+      output += static_cast<char>(value.asBool() ? TRUE_VALUE : FALSE_VALUE);
+      break;
+
+    case Json::intValue: {
+      Json::LargestInt number = value.asLargestInt();
+      if (number >= 0)
+        write_head(UNSIGNED_INTEGER, static_cast<uint64_t>(number), output);
+      else
+        write_head(NEGATIVE_INTEGER, ~static_cast<uint64_t>(number), output);
+      break;
+    }
+
+    case Json::uintValue:
+      write_head(UNSIGNED_INTEGER, value.asLargestUInt(), output);
+      break;
+
+    case Json::realValue:
+      write_double(value.asDouble(), output);
+      break;
+
+    case Json::stringValue: {
+      const char* begin = "";
+      const char* end = begin;
+      value.getString(&begin, &end);
+      write_head(TEXT_STRING, end - begin, output);
+      output.append(begin, end - begin);
+      break;
+    }
+
+    case Json::arrayValue: {
+      Json::ArrayIndex size = value.size();
+      write_head(ARRAY, size, output);
+      for (Json::ArrayIndex index = 0; index < size; index++)
+        write(value[index], output);
+      break;
+    }
+
+    case Json::objectValue: {
+      write_head(MAP, value.size(), output);
+      for (auto member = value.begin(); member != value.end(); ++member) {
+        const char* end;
+        const char* name = member.memberName(&end);
+        write_head(TEXT_STRING, end - name, output);
+        output.append(name, end - name);
+        write(*member, output);
+      }
+      break;
+    }
+  }
+}
+
+//! argument of item with additional information `info`, which is not indefinite one
+static bool read_argument(const unsigned char*& p, const unsigned char* end, uint8_t info, uint64_t& argument) {
+  if (info < 24) {
+    argument = info;
+    return true;
+  }
+  if (info > 27)
+    return false;
+  return BodyFormat::take(p, end, 1 << (info - 24), argument);
+}
+
+static double half_to_double(uint16_t half) {
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  double value;
+
+  if (exponent == 0)
+    value = std::ldexp(mantissa, -24);
+  else if (exponent != 31)
+    value = std::ldexp(mantissa + 1024, exponent - 25);
+  else
+    value = mantissa == 0 ? INFINITY : NAN;
+
+  return half & 0x8000 ? -value : value;
+}
+
+//! appends byte or text string of `major` type, indefinite one is made of definite chunks
+static bool read_string(const unsigned char*& p, const unsigned char* end, uint8_t major, uint8_t info, std::string& output) {
+  if (info != INDEFINITE) {
+    uint64_t length;
+    if (!read_argument(p, end, info, length) || length > static_cast<uint64_t>(end - p))
+      return false;
+    output.append(reinterpret_cast<const char*>(p), length);
+    p += length;
+    return true;
+  }
+
+  while (p < end && *p != BREAK) {
+    uint8_t type = *p++;
+    if ((type >> 5) != major || (type & 0x1f) == INDEFINITE)
+      return false;
+    if (!read_string(p, end, major, type & 0x1f, output))
+      return false;
+  }
+
+  return p++ < end;
+}
+
+static bool read_value(const unsigned char*& p, const unsigned char* end, Json::Value& value, size_t depth) {
+  if (p == end || depth > BodyFormat::MAX_DEPTH)
+    return false;
+
+  uint8_t type = *p++;
+  uint8_t major = type >> 5;
+  uint8_t info = type & 0x1f;
+  uint64_t argument = 0;
+
+  if (info == INDEFINITE ? (major < BYTE_STRING || major == TAG) : !read_argument(p, end, info, argument))
+    return false;
+
+  switch (major) {
+    case UNSIGNED_INTEGER:
+      value = BodyFormat::integer(argument, false);
+      return true;
+
+    case NEGATIVE_INTEGER:
+      // -1 - argument, which may not fit into 64 bits
+      if (argument == UINT64_MAX)
+        value = -18446744073709551616.0;
+      else
+        value = BodyFormat::integer(argument + 1, true);
+      return true;
+
+    case BYTE_STRING:
+    case TEXT_STRING:
+      // definite strings (as most of them are) are not copied twice
+      if (info != INDEFINITE) {
+        if (argument > static_cast<uint64_t>(end - p))
+          return false;
+        value = Json::Value(reinterpret_cast<const char*>(p), reinterpret_cast<const char*>(p + argument));
+        p += argument;
+      } else {
+        std::string string;
+        if (!read_string(p, end, major, info, string))
+          return false;
+        value = Json::Value(string.data(), string.data() + string.size());
+      }
+      return true;
+
+    case ARRAY: {
+      // every item takes at least one byte
+      if (info != INDEFINITE && argument > static_cast<uint64_t>(end - p))
+        return false;
+
+      value = Json::Value(Json::arrayValue);
+      for (Json::ArrayIndex index = 0; info == INDEFINITE || index < argument; index++) {
+        if (info == INDEFINITE && p < end && *p == BREAK) {
+          p++;
+          break;
+        }
+        if (!read_value(p, end, value[index], depth + 1))
+          return false;
+      }
+      return true;
+    }
+
+    case MAP: {
+      if (info != INDEFINITE && argument > static_cast<uint64_t>(end - p) / 2)
+        return false;
+
+      BodyFormat::Members members;
+      if (info != INDEFINITE)
+        members.reserve(argument);
+
+      for (uint64_t i = 0; info == INDEFINITE || i < argument; i++) {
+        if (p == end)
+          return false;
+        if (info == INDEFINITE && *p == BREAK) {
+          p++;
+          break;
+        }
+
+        uint8_t key_type = *p++;
+        members.emplace_back(std::string(), Json::Value());
+        if ((key_type >> 5) != TEXT_STRING || !read_string(p, end, TEXT_STRING, key_type & 0x1f, members.back().first))
+          return false;
+        if (!read_value(p, end, members.back().second, depth + 1))
+          return false;
+      }
+
+      BodyFormat::assign(value, members);
+      return true;
+    }
+
+    case TAG:
+      // meaning of tags is not kept, only value they tag
+      return read_value(p, end, value, depth + 1);
+
+    default:
+      switch (type) {
+        case FALSE_VALUE:
+        case TRUE_VALUE:
+          value = type == TRUE_VALUE;
+          return true;
+
+        case NULL_VALUE:
+        case UNDEFINED_VALUE:
+          value = Json::Value();
+          return true;
+
+        case HALF_FLOAT:
+          value = half_to_double(static_cast<uint16_t>(argument));
+          return true;
+
+        case SINGLE_FLOAT: {
+          uint32_t bits = static_cast<uint32_t>(argument);
+          float single;
+          memcpy(&single, &bits, sizeof(single));
+          value = static_cast<double>(single);
+          return true;
+        }
+
+        case DOUBLE_FLOAT: {
+          double real;
+          memcpy(&real, &argument, sizeof(real));
+          value = real;
+          return true;
+        }
+
+        default:
+          return false;
+      }
+  }
+}
+
+bool Cbor::read(const char* data, size_t size, Json::Value& value) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+  return read_value(p, end, value, 0) && p == end;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef REST_CPP_CBOR_H
+#define REST_CPP_CBOR_H
+
+#include <string>
+
+#include "json/json.h"
+
+namespace REST {
+
+/**
+ * Cbor encodes Json::Value as CBOR (RFC 8949) and decodes it back.
+ * Integers and lengths take the shortest form which fits them,
+ * doubles are written as single precision floats when that keeps
+ * their value.
+ *
+ * Decoding accepts indefinite length items and half precision
+ * floats, byte strings are decoded as strings and tags are
+ * skipped. Map keys have to be text strings.
+ *
+ * @private
+ * @see BodyFormat
+ */
+class Cbor final {
+
+  public:
+    //! appends `value` to `output`
+    static void write(Json::Value const& value, std::string& output);
+    //! decodes single value taking whole `size` bytes, false if it is not valid
+    static bool read(const char* data, size_t size, Json::Value& value);
+};
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "clock.h"
+
+namespace REST {
+
+char Clock::buffers[2][Clock::DATE_LENGTH + 1];
+std::atomic<int> Clock::current(0);
+std::atomic<time_t> Clock::second(0);
+std::atomic_flag Clock::refreshing = ATOMIC_FLAG_INIT;
+
+//! formats date before anybody asks for it
+struct ClockInitializer {
+  ClockInitializer() {
+    Clock::refresh(time(0));
+  }
+} clock_initializer;
+
+StringView Clock::date() {
+  time_t now = time(0);
+
+  if (now != second.load(std::memory_order_acquire))
+    refresh(now);
+
+  return StringView(buffers[current.load(std::memory_order_acquire)], DATE_LENGTH);
+}
+
+void Clock::refresh(time_t now) {
+  // somebody else is formatting it, previous second is fine
+  if (refreshing.test_and_set(std::memory_order_acquire))
+    return;
+
+  if (now != second.load(std::memory_order_relaxed)) {
+    int next = 1 - current.load(std::memory_order_relaxed);
+    struct tm time_info;
+
+    gmtime_r(&now, &time_info);
+    strftime(buffers[next], sizeof(buffers[next]), "%a, %d %b %Y %H:%M:%S GMT", &time_info);
+
+    current.store(next, std::memory_order_release);
+    second.store(now, std::memory_order_release);
+  }
+
+  refreshing.clear(std::memory_order_release);
+}
+
+}
@@ -0,0 +1,40 @@
+#ifndef REST_CPP_CLOCK_H
+#define REST_CPP_CLOCK_H
+
+#include <atomic>
+#include <ctime>
+#include "string_view.h"
+
+namespace REST {
+
+/**
+ * Clock keeps current date formatted for Date header. It is
+ * formatted at most once per second, by first thread which
+ * notices that second changed, into one of two buffers, so
+ * other threads read the other one without any lock.
+ *
+ * @private
+ * @see Response
+ */
+class Clock final {
+
+  public:
+    //! current date in RFC 1123 format, i.e. "Sun, 06 Nov 1994 08:49:37 GMT"
+    static StringView date();
+
+  private:
+    friend struct ClockInitializer;
+
+    static void refresh(time_t now);
+
+    const static size_t DATE_LENGTH = 29;
+
+    static char buffers[2][DATE_LENGTH + 1];
+    static std::atomic<int> current;
+    static std::atomic<time_t> second;
+    static std::atomic_flag refreshing;
+};
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include "compressor.h"
+#include "header.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace REST {
+
+int Compressor::LEVEL = 6;
+size_t Compressor::MIN_SIZE = 1024;
+
+static const size_t STREAM_CHUNK = 16384;
+
+//! encodings supported, in order of preference
+static const struct {
+  Compressor::Encoding encoding;
+  StringView name;
+} ENCODINGS[] = {
+#ifdef WITH_ZSTD
+  { Compressor::ZSTD, "zstd" },
+#endif
+  { Compressor::GZIP, "gzip" },
+  { Compressor::DEFLATE, "deflate" }
+};
+
+static StringView trim(const char* begin, const char* end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
+  return StringView(begin, end - begin);
+}
+
+/**
+ * Weight of `coding` in Accept-Encoding, -1 if it is not listed.
+ * Coding `*` stands for any other one.
+ */
+static double weight(StringView const& value, StringView const& coding) {
+  double any = -1;
+  const char* position = value.begin();
+
+  while (position < value.end()) {
+    const char* next = static_cast<const char*>(memchr(position, ',', value.end() - position));
+    if (next == nullptr)
+      next = value.end();
+
+    const char* semicolon = static_cast<const char*>(memchr(position, ';', next - position));
+    StringView name = trim(position, semicolon != nullptr ? semicolon : next);
+    double q = 1;
+
+    if (semicolon != nullptr) {
+      StringView parameter = trim(semicolon + 1, next);
+      if (parameter.starts_with("q="))
+        q = strtod(std::string(parameter.data() + 2, parameter.size() - 2).c_str(), nullptr);
+    }
+
+    if (Header::equals(name, coding))
+      return q;
+
+    if (name == "*")
+      any = q;
+
+    position = next + 1;
+  }
+
+  return any;
+}
+
+Compressor::Compressor() {
+  memset(&deflate_stream, 0, sizeof(deflate_stream));
+  memset(&gzip_stream, 0, sizeof(gzip_stream));
+}
+
+Compressor::~Compressor() {
+  if (deflate_ready)
+    deflateEnd(&deflate_stream);
+  if (gzip_ready)
+    deflateEnd(&gzip_stream);
+#ifdef WITH_ZSTD
+  if (zstd != nullptr)
+    ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(zstd));
+#endif
+}
+
+Compressor::Encoding Compressor::negotiate(StringView const& accept_encoding) {
+  Encoding best = IDENTITY;
+  double best_weight = 0;
+
+  for (auto const& candidate : ENCODINGS) {
+    double q = weight(accept_encoding, candidate.name);
+    if (q > best_weight) {
+      best = candidate.encoding;
+      best_weight = q;
+    }
+  }
+
+  return best;
+}
+
+bool Compressor::accepts(StringView const& accept_encoding, StringView const& coding) {
+  return weight(accept_encoding, coding) > 0;
+}
+
+StringView Compressor::name(Encoding encoding) {
+  for (auto const& candidate : ENCODINGS)
+    if (candidate.encoding == encoding)
+      return candidate.name;
+
+  return "identity";
+}
+
+bool Compressor::is_compressible(StringView const& content_type) {
+  return content_type.starts_with("text/") ||
+    content_type.find("json") != StringView::npos ||
+    content_type.find("javascript") != StringView::npos ||
+    content_type.find("xml") != StringView::npos;
+}
+
+z_stream* Compressor::zlib(Encoding encoding) {
+  bool& ready = encoding == GZIP ? gzip_ready : deflate_ready;
+  z_stream* stream = encoding == GZIP ? &gzip_stream : &deflate_stream;
+
+  if (ready)
+    return deflateReset(stream) == Z_OK ? stream : nullptr;
+
+  // gzip differs in header and trailer only
+  int window_bits = encoding == GZIP ? 15 + 16 : 15;
+  if (deflateInit2(stream, LEVEL, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return nullptr;
+
+  ready = true;
+  return stream;
+}
+
+bool Compressor::compress(Encoding encoding, const char* data, size_t size, std::string& output) {
+  active = IDENTITY;
+
+#ifdef WITH_ZSTD
+  if (encoding == ZSTD) {
+    if (zstd == nullptr && (zstd = ZSTD_createCCtx()) == nullptr)
+      return false;
+
+    output.resize(ZSTD_compressBound(size));
+    size_t length = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(zstd), &output[0], output.size(), data, size, LEVEL);
+    if (ZSTD_isError(length))
+      return false;
+
+    output.resize(length);
+    return true;
+  }
+#endif
+
+  if (encoding != GZIP && encoding != DEFLATE)
+    return false;
+
+  z_stream* stream = zlib(encoding);
+  if (stream == nullptr)
+    return false;
+
+  // whole output fits, single deflate() call is enough
+  output.resize(deflateBound(stream, size));
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = size;
+  stream->next_out = reinterpret_cast<Bytef*>(&output[0]);
+  stream->avail_out = output.size();
+
+  if (deflate(stream, Z_FINISH) != Z_STREAM_END)
+    return false;
+
+  output.resize(stream->total_out);
+  return true;
+}
+
+bool Compressor::begin(Encoding encoding) {
+  active = IDENTITY;
+
+#ifdef WITH_ZSTD
+  if (encoding == ZSTD) {
+    if (zstd == nullptr && (zstd = ZSTD_createCCtx()) == nullptr)
+      return false;
+
+    ZSTD_CCtx_reset(static_cast<ZSTD_CCtx*>(zstd), ZSTD_reset_session_only);
+    ZSTD_CCtx_setParameter(static_cast<ZSTD_CCtx*>(zstd), ZSTD_c_compressionLevel, LEVEL);
+    active = ZSTD;
+    return true;
+  }
+#endif
+
+  if ((encoding != GZIP && encoding != DEFLATE) || zlib(encoding) == nullptr)
+    return false;
+
+  active = encoding;
+  return true;
+}
+
+bool Compressor::update(const char* data, size_t size, std::string& output, Flush flush) {
+#ifdef WITH_ZSTD
+  if (active == ZSTD) {
+    ZSTD_EndDirective mode = flush == Flush::FINISH ? ZSTD_e_end : flush == Flush::SYNC ? ZSTD_e_flush : ZSTD_e_continue;
+    ZSTD_inBuffer input = { data, size, 0 };
+    size_t remaining;
+
+    do {
+      size_t start = output.size();
+      output.resize(start + STREAM_CHUNK);
+      ZSTD_outBuffer out = { &output[start], STREAM_CHUNK, 0 };
+
+      remaining = ZSTD_compressStream2(static_cast<ZSTD_CCtx*>(zstd), &out, &input, mode);
+      output.resize(start + out.pos);
+
+      if (ZSTD_isError(remaining))
+        return false;
+    } while (input.pos < input.size || (mode != ZSTD_e_continue && remaining > 0));
+
+    return true;
+  }
+#endif
+
+  if (active != GZIP && active != DEFLATE)
+    return false;
+
+  z_stream* stream = active == GZIP ? &gzip_stream : &deflate_stream;
+  int mode = flush == Flush::FINISH ? Z_FINISH : flush == Flush::SYNC ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+
+  stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream->avail_in = size;
+
+  // until input is consumed and nothing is left in the stream
+  do {
+    size_t start = output.size();
+    output.resize(start + STREAM_CHUNK);
+    stream->next_out = reinterpret_cast<Bytef*>(&output[start]);
+    stream->avail_out = STREAM_CHUNK;
+
+    int status = deflate(stream, mode);
+    output.resize(start + STREAM_CHUNK - stream->avail_out);
+
+    if (status == Z_STREAM_ERROR)
+      return false;
+  } while (stream->avail_out == 0 || stream->avail_in > 0);
+
+  return true;
+}
+
+}
@@ -0,0 +1,74 @@
+#ifndef REST_CPP_COMPRESSOR_H
+#define REST_CPP_COMPRESSOR_H
+
+#include <string>
+#include <zlib.h>
+
+#include "string_view.h"
+
+namespace REST {
+
+/**
+ * Compressor compresses response bodies with encoding chosen from
+ * client's Accept-Encoding. Every Worker owns one, so its zlib
+ * (and zstd) contexts are allocated once and reset for every
+ * response.
+ *
+ * Bodies smaller than MIN_SIZE are sent as they are, LEVEL 0
+ * disables compression. zstd is available only when library is
+ * built with WITH_ZSTD.
+ *
+ * @private
+ * @see Response
+ */
+class Compressor final {
+
+  public:
+    enum Encoding { IDENTITY, DEFLATE, GZIP, ZSTD };
+    enum class Flush { NONE, SYNC, FINISH };
+
+    static int LEVEL;
+    static size_t MIN_SIZE;
+
+    Compressor();
+    ~Compressor();
+
+    Compressor(Compressor const&) = delete;
+    Compressor& operator=(Compressor const&) = delete;
+
+    //! best encoding client accepts, IDENTITY if there is none
+    static Encoding negotiate(StringView const& accept_encoding);
+    //! whether `coding` is listed in Accept-Encoding without zero weight
+    static bool accepts(StringView const& accept_encoding, StringView const& coding);
+    static StringView name(Encoding encoding);
+    //! text-like content, images and archives are compressed already
+    static bool is_compressible(StringView const& content_type);
+
+    //! compresses whole `size` bytes of `data` into `output`
+    bool compress(Encoding encoding, const char* data, size_t size, std::string& output);
+
+    //! starts new stream, which is fed by update()
+    bool begin(Encoding encoding);
+    /**
+     * Appends compressed `data` to `output`. SYNC flushes what
+     * was compressed so far, so client can decompress it already,
+     * FINISH ends the stream.
+     */
+    bool update(const char* data, size_t size, std::string& output, Flush flush);
+
+  private:
+    z_stream* zlib(Encoding encoding);
+
+    z_stream deflate_stream;
+    z_stream gzip_stream;
+    bool deflate_ready = false;
+    bool gzip_ready = false;
+    //! ZSTD_CCtx, layout does not depend on how library was built
+    void* zstd = nullptr;
+
+    Encoding active = IDENTITY;
+};
+
+}
+
+#endif
@@ -0,0 +1,380 @@
+#include "connection.h"
+#include "reaper.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+// Worker ignores SIGPIPE where sends cannot suppress it
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace REST {
+
+const size_t Connection::BUFFER_SIZE = 4096;
+const size_t Connection::MAX_PENDING_OUTPUT = 1 << 20;
+const int Connection::MAX_IOVECS = 64;
+
+size_t Connection::MAX_REQUESTS = 1000;
+int Connection::IDLE_TIMEOUT = 15;
+
+Connection::Connection(Request::client const& client, Poller* p) :
+  handle(client.handle), address(client.address), poller(p), last_activity(time(0)) {
+  Poller::set_blocking(handle, false);
+  poller->add(handle, this);
+}
+
+Connection::~Connection() {
+  // streamer is still writing, let it know client is gone
+  if (writer)
+    writer->close();
+
+  if (state != State::DETACHED) {
+    poller->remove(handle);
+    close(handle);
+  }
+}
+
+bool Connection::receive() {
+  char buffer[BUFFER_SIZE];
+
+  // requests taken already are no longer referenced
+  if (consumed > 0) {
+    input.erase(0, consumed);
+    consumed = 0;
+  }
+
+  // edge triggered - read until socket is empty
+  while (true) {
+    ssize_t length = recv(handle, buffer, BUFFER_SIZE, 0);
+
+    if (length > 0) {
+      if (state == State::READING || state == State::STREAMING)
+        input.append(buffer, length);
+      last_activity = time(0);
+      continue;
+    }
+
+    if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+
+    if (length == -1 && errno == EINTR)
+      continue;
+
+    if (length == 0)
+      eof = true;
+    else
+      closed = true;
+    return false;
+  }
+}
+
+bool Connection::has_request() {
+  if (state != State::READING)
+    return false;
+
+  Parser::Status status = parser.parse(input.data() + consumed, input.size() - consumed);
+
+  if (status == Parser::Status::ERROR) {
+    write("HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+    finish();
+    return false;
+  }
+
+  // body is refused before it is buffered
+  if (status == Parser::Status::TOO_LARGE) {
+    write("HTTP/1.1 413 Payload Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+    finish();
+    return false;
+  }
+
+  return status == Parser::Status::COMPLETE;
+}
+
+bool Connection::is_finished() {
+  if (closed)
+    return true;
+
+  if (!eof)
+    return false;
+
+  // client will not send anything more, but it still
+  // waits for responses of what it has already sent
+  return state == State::READING && output.empty() && !has_request();
+}
+
+bool Connection::is_idle(time_t now) const {
+  return now - last_activity >= IDLE_TIMEOUT;
+}
+
+bool Connection::is_congested() const {
+  return output_size > MAX_PENDING_OUTPUT;
+}
+
+bool Connection::is_reusable() const {
+  return requests < MAX_REQUESTS;
+}
+
+void Connection::take_request() {
+  consumed += parser.length;
+  parser.reset();
+  requests++;
+}
+
+void Connection::write(std::string const& data) {
+  if (data.empty())
+    return;
+
+  output.push_back(Chunk(std::string(data)));
+  output_size += data.size();
+}
+
+void Connection::write(struct iovec const* parts, int count, std::string&& body) {
+  size_t sent = 0;
+
+  // nothing is waiting, try to send it right away
+  if (output.empty() && state != State::DETACHED && !closed && count < MAX_IOVECS) {
+    struct iovec vectors[MAX_IOVECS];
+    for (int i = 0; i < count; i++)
+      vectors[i] = parts[i];
+    vectors[count].iov_base = const_cast<char*>(body.data());
+    vectors[count].iov_len = body.size();
+
+    if (send(vectors, count + 1, sent) || closed)
+      return;
+  }
+
+  // keep the rest until socket is writable
+  for (int i = 0; i < count; i++) {
+    if (sent >= parts[i].iov_len) {
+      sent -= parts[i].iov_len;
+      continue;
+    }
+
+    write(std::string(static_cast<const char*>(parts[i].iov_base) + sent, parts[i].iov_len - sent));
+    sent = 0;
+  }
+
+  if (sent < body.size()) {
+    output_size += body.size() - sent;
+    output.push_back(Chunk(std::move(body)));
+    if (output.size() == 1)
+      output_offset = sent;
+    else
+      output.back().data.erase(0, sent);
+  }
+}
+
+void Connection::write(File::shared const& file, off_t offset, size_t length) {
+  if (length == 0)
+    return;
+
+  if (output.empty() && state != State::DETACHED && !closed) {
+    if (send(*file, offset, length) || closed)
+      return;
+  }
+
+  output.push_back(Chunk(file, offset, length));
+}
+
+bool Connection::send(struct iovec* vectors, int count, size_t& sent) {
+  size_t total = 0;
+  for (int i = 0; i < count; i++)
+    total += vectors[i].iov_len;
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = vectors;
+  message.msg_iovlen = count;
+
+  sent = 0;
+
+  while (sent < total) {
+    ssize_t length = sendmsg(handle, &message, MSG_NOSIGNAL);
+
+    if (length > 0) {
+      sent += length;
+      last_activity = time(0);
+
+      // skip what was sent
+      while (message.msg_iovlen > 0 && (size_t) length >= message.msg_iov->iov_len) {
+        length -= message.msg_iov->iov_len;
+        message.msg_iov++;
+        message.msg_iovlen--;
+      }
+      if (message.msg_iovlen > 0) {
+        message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + length;
+        message.msg_iov->iov_len -= length;
+      }
+      continue;
+    }
+
+    if (length == -1 && errno == EINTR)
+      continue;
+
+    if (!(length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+      closed = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool Connection::send(File const& file, off_t& offset, size_t& length) {
+  while (length > 0) {
+#ifdef __linux__
+    ssize_t sent = sendfile(handle, file.handle, &offset, length);
+#else
+    // no portable sendfile, read it through small buffer
+    char buffer[BUFFER_SIZE * 4];
+    ssize_t sent = pread(file.handle, buffer, length < sizeof(buffer) ? length : sizeof(buffer), offset);
+    if (sent > 0) {
+      sent = ::send(handle, buffer, sent, MSG_NOSIGNAL);
+      if (sent > 0)
+        offset += sent;
+    }
+#endif
+
+    if (sent > 0) {
+      length -= sent;
+      last_activity = time(0);
+      continue;
+    }
+
+    // file got shorter, it cannot be sent whole anymore
+    if (sent == 0) {
+      closed = true;
+      return false;
+    }
+
+    if (sent == -1 && errno == EINTR)
+      continue;
+
+    if (!(sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+      closed = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool Connection::flush() {
+  while (!output.empty()) {
+    if (output.front().file) {
+      Chunk& chunk = output.front();
+      if (!send(*chunk.file, chunk.offset, chunk.length))
+        return false;
+
+      output.pop_front();
+      continue;
+    }
+
+    struct iovec vectors[MAX_IOVECS];
+    int count = 0;
+
+    // data chunks up to next file one
+    for (auto chunk = output.begin(); chunk != output.end() && !chunk->file && count < MAX_IOVECS; ++chunk, ++count) {
+      size_t offset = count == 0 ? output_offset : 0;
+      vectors[count].iov_base = const_cast<char*>(chunk->data.data()) + offset;
+      vectors[count].iov_len = chunk->data.size() - offset;
+    }
+
+    size_t sent = 0;
+    bool complete = send(vectors, count, sent);
+
+    output_size -= sent;
+    sent += output_offset;
+    output_offset = 0;
+
+    while (!output.empty() && !output.front().file && sent >= output.front().data.size()) {
+      sent -= output.front().data.size();
+      output.pop_front();
+    }
+    output_offset = sent;
+
+    if (!complete)
+      return false;
+  }
+
+  output_offset = 0;
+  return true;
+}
+
+void Connection::finish() {
+  // no more requests will be served, close after output is sent
+  if (state == State::READING)
+    state = State::WRITING;
+}
+
+void Connection::linger() {
+  poller->remove(handle);
+  state = State::DETACHED;
+
+  // client is gone or closed its side already
+  if (eof || closed) {
+    close(handle);
+    return;
+  }
+
+  // close our side, Reaper waits for client to close its one,
+  // so unread data does not turn close into reset
+  shutdown(handle, SHUT_WR);
+  Reaper::instance()->adopt(handle);
+}
+
+void Connection::stream(Writer::shared const& w) {
+  writer = w;
+  writer->poller = poller;
+  writer->asynchronous = true;
+  state = State::STREAMING;
+}
+
+void Connection::pump() {
+  if (state != State::STREAMING)
+    return;
+
+  if (writer->drain(this)) {
+    // stream ended, requests which came meanwhile may be served
+    state = writer->keep_alive ? State::READING : State::WRITING;
+    writer.reset();
+  }
+}
+
+bool Connection::wait_flush() {
+  while (!flush()) {
+    if (closed)
+      return false;
+
+    struct pollfd writable = { handle, POLLOUT, 0 };
+    int count = poll(&writable, 1, IDLE_TIMEOUT * 1000);
+
+    // client does not read at all
+    if (count == 0 || (count == -1 && errno != EINTR)) {
+      closed = true;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Connection::detach() {
+  if (state == State::DETACHED)
+    return;
+
+  poller->remove(handle);
+  Poller::set_blocking(handle, true);
+
+  // push out everything that was written so far
+  flush();
+
+  state = State::DETACHED;
+}
+
+}
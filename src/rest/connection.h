@@ -0,0 +1,129 @@
+#ifndef REST_CPP_CONNECTION_H
+#define REST_CPP_CONNECTION_H
+
+#include <string>
+#include <deque>
+#include <ctime>
+#include <sys/uio.h>
+#include "request.h"
+#include "poller.h"
+#include "parser.h"
+#include "file.h"
+#include "writer.h"
+
+namespace REST {
+
+/**
+ * Connection is non-blocking client socket owned by single
+ * Worker. It buffers incoming bytes until Parser finds whole
+ * request in them and keeps output, which could not be written
+ * at once, until socket becomes writable again. Request copies
+ * what it refers to, so buffer may be reused once request is
+ * taken.
+ *
+ * Connection is persistent (HTTP/1.1 keep-alive) until client
+ * asks to close it, it served MAX_REQUESTS requests or it was
+ * idle for IDLE_TIMEOUT seconds. Pipelined requests are served
+ * in order and their responses are written together.
+ *
+ * Output is list of separate chunks (response heads and bodies)
+ * written with single writev(), so bodies are never copied into
+ * one buffer. File bodies are sent with sendfile() straight from
+ * the file.
+ *
+ * @private
+ * @see Worker
+ */
+class Connection final {
+
+  public:
+    enum class State { READING, STREAMING, WRITING, DETACHED };
+
+    static size_t MAX_REQUESTS;
+    static int IDLE_TIMEOUT;
+
+    Connection(Request::client const& client, Poller* poller);
+    ~Connection();
+
+    bool receive();
+    bool has_request();
+    const char* request_data() const { return input.data() + consumed; }
+    void take_request();
+
+    void write(std::string const& data);
+
+    /**
+     * Writes `parts` followed by `body` at once, if nothing else
+     * waits to be sent (and there are less than MAX_IOVECS parts).
+     * Only what could not be sent is kept - `parts` are copied
+     * then, `body` is moved.
+     */
+    void write(struct iovec const* parts, int count, std::string&& body);
+    //! sends `length` bytes of `file` from `offset`, after what was written before
+    void write(File::shared const& file, off_t offset, size_t length);
+    bool flush();
+    void finish();
+    //! hands socket over to Reaper, when response is sent
+    void linger();
+    //! gives socket (blocking) to streamer, when headers are sent
+    void detach();
+    //! takes chunks from asynchronous `writer` until its stream ends
+    void stream(Writer::shared const& writer);
+    //! moves chunks written meanwhile to output
+    void pump();
+    //! flushes output, waiting for socket if needed, false if client is gone
+    bool wait_flush();
+
+    bool is_finished();
+    bool is_idle(time_t now) const;
+    bool is_congested() const;
+    bool is_reusable() const;
+    bool is_closed() const { return closed; }
+
+    int handle;
+    struct sockaddr_storage address;
+    State state = State::READING;
+    Parser parser;
+
+  private:
+    const static size_t BUFFER_SIZE;
+    const static size_t MAX_PENDING_OUTPUT;
+    const static int MAX_IOVECS;
+
+    /**
+     * Output chunk is either data or part of file. Only file
+     * chunks keep their own position, `output_offset` is used
+     * for data ones.
+     */
+    struct Chunk {
+      std::string data;
+      File::shared file;
+      off_t offset;
+      size_t length;
+
+      Chunk(std::string&& d) : data(std::move(d)), offset(0), length(0) {}
+      Chunk(File::shared const& f, off_t o, size_t l) : file(f), offset(o), length(l) {}
+    };
+
+    bool send(struct iovec* vectors, int count, size_t& sent);
+    bool send(File const& file, off_t& offset, size_t& length);
+
+    Poller* poller;
+    Writer::shared writer;
+
+    std::string input;
+    std::deque<Chunk> output;
+    //! bytes of first output chunk which were sent already
+    size_t output_offset = 0;
+    //! bytes of data chunks, files are not kept in memory
+    size_t output_size = 0;
+    size_t consumed = 0;
+    size_t requests = 0;
+    time_t last_activity;
+    bool eof = false;
+    bool closed = false;
+};
+
+}
+
+#endif
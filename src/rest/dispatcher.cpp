@@ -1,14 +1,22 @@
 #include "dispatcher.h"
+#include "streamers.h"
+
+#ifdef __linux__
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
 
 namespace REST {
 
 Dispatcher::Dispatcher(int wc, int sc) : workers_count(wc), streamers_count(sc) {
-  Worker::POOL_SIZE = workers_count;
-  clients_count.resize(workers_count);
+  // streams of every worker share one pool
+  Streamers::start(workers_count * streamers_count);
+
+  clients_count = std::vector< Load, Load::Allocator<Load> >(workers_count);
   workers.resize(workers_count);
 
   for (int i = 0; i < workers_count; i++) {
-    workers[i] = std::make_shared<Worker>(i, sc, &clients_count[i]);
+    workers[i] = std::make_shared<Worker>(i, &clients_count[i]);
   }
 }
 
@@ -20,14 +28,44 @@ Dispatcher::~Dispatcher() {
 }
 
 void Dispatcher::dispatch(int worker_id, Request::client client) {
-  std::unique_lock<std::mutex> lock(workers[worker_id]->clients_queue_lock);
+  clients_count[worker_id].increment();
+
+  if (!workers[worker_id]->push(client)) {
+    clients_count[worker_id].decrement();
+    throw QueueFullError();
+  }
+
+  dispatched(worker_id);
+}
+
+void Dispatcher::listen(struct addrinfo const* address, bool affinity) {
+  std::vector<int> handles;
+  for (auto& worker : workers)
+    handles.push_back(worker->listen(address));
+
+  if (!affinity)
+    return;
+
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  int cpus = std::thread::hardware_concurrency();
+  if (cpus <= 0)
+    cpus = 1;
 
-  workers[worker_id]->clients_queue.push(client);
-  clients_count[worker_id]++;
+  for (int i = 0; i < workers_count; i++)
+    workers[i]->pin(i % cpus);
 
-  lock.unlock();
-  workers[worker_id]->clients_queue_ready.notify_one();
+  // sockets in reuseport group are numbered in order they were
+  // bound, so worker `cpu % workers_count` takes the connection
+  struct sock_filter code[] = {
+    { BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t) (SKF_AD_OFF + SKF_AD_CPU) },
+    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t) workers_count },
+    { BPF_RET | BPF_A, 0, 0, 0 }
+  };
+  struct sock_fprog program = { sizeof(code) / sizeof(code[0]), code };
 
+  if (setsockopt(handles[0], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == -1)
+    std::cerr << "!!! Cannot attach CPU steering program, connections are spread by hash" << std::endl;
+#endif
 }
 
 void Dispatcher::next(Request::client client) {
@@ -2,6 +2,7 @@
 #define REST_CPP_DISPATCHER_H
 
 #include <netinet/in.h>
+#include <netdb.h>
 #include <vector>
 #include <queue>
 #include <iostream>
@@ -11,6 +12,7 @@
 #include <atomic>
 
 #include "worker.h"
+#include "load.h"
 #include "request.h"
 #include "router.h"
 
@@ -33,14 +35,27 @@ class Dispatcher {
     void dispatch(int worker_id, Request::client client);
     void next(Request::client client);
 
+    /**
+     * Makes every Worker listen on address on its own and accept
+     * clients itself, instead of getting them from dispatch().
+     * With `affinity`, Workers are pinned to CPUs and kernel is
+     * told to pass connection to Worker running on CPU which
+     * received it (Linux only).
+     */
+    void listen(struct addrinfo const* address, bool affinity);
+
+    //! number of workers
+    int size() const { return workers_count; }
+
   protected:
     virtual int next_worker_id() = 0;
+    //! called after client was handed over to worker
+    virtual void dispatched(int worker_id) {}
 
     int workers_count = 0;
     int streamers_count = 0;
     std::vector< std::shared_ptr<Worker> > workers;
-    std::vector< size_t > clients_count;
-    // size_t* clients_count;
+    std::vector< Load, Load::Allocator<Load> > clients_count;
 };
 
 }
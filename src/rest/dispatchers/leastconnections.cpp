@@ -7,7 +7,8 @@ namespace REST {
 namespace Dispatchers {
 
 int LeastConnections::next_worker_id() {
-  return std::distance(clients_count.begin(), std::min_element(clients_count.begin(), clients_count.end()));
+  return std::distance(clients_count.begin(), std::min_element(clients_count.begin(), clients_count.end(),
+    [] (Load const& a, Load const& b) { return a.get() < b.get(); }));
 }
 
 }
@@ -0,0 +1,30 @@
+#include "leastlatency.h"
+
+namespace REST {
+
+namespace Dispatchers {
+
+int LeastLatency::next_worker_id() {
+  int best = 0;
+  double best_wait = 0;
+  size_t best_count = 0;
+
+  for (int i = 0; i < workers_count; i++) {
+    // worker which served nothing yet is as good as idle, equal
+    // waits (such as all of them at start) go to fewer connections
+    size_t count = clients_count[i].get();
+    double wait = (count + 1) * clients_count[i].latency();
+
+    if (i == 0 || wait < best_wait || (wait == best_wait && count < best_count)) {
+      best = i;
+      best_wait = wait;
+      best_count = count;
+    }
+  }
+
+  return best;
+}
+
+}
+
+}
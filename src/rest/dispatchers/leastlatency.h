@@ -0,0 +1,29 @@
+#ifndef REST_CPP_DISPATCHER_LEASTLATENCY_H
+#define REST_CPP_DISPATCHER_LEASTLATENCY_H
+
+#include "../dispatcher.h"
+
+namespace REST {
+
+namespace Dispatchers {
+
+/**
+ * Selects Worker with lowest expected wait - its connections
+ * count times its average service time - so Workers busy with
+ * expensive requests get less new clients than ones serving
+ * cheap requests. Workers which did not serve anything yet (so
+ * their wait is 0) are chosen by connections count.
+ */
+class LeastLatency final : public Dispatcher {
+  public:
+    LeastLatency(int workers_count, int sc) : Dispatcher(workers_count, sc) { };
+
+  private:
+    int next_worker_id();
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "poweroftwo.h"
+#include <random>
+#include <cstdint>
+
+namespace REST {
+
+namespace Dispatchers {
+
+// xorshift64*, state is per thread so there is nothing to share
+static uint64_t next_random() {
+  static thread_local uint64_t state = std::random_device()() | 1;
+
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+
+  return state * 2685821657736338717ULL;
+}
+
+int PowerOfTwo::next_worker_id() {
+  if (workers_count == 1)
+    return 0;
+
+  uint64_t random = next_random();
+  int first = (random >> 32) % workers_count;
+  int second = (random & 0xffffffff) % (workers_count - 1);
+
+  // two different workers
+  if (second >= first)
+    second++;
+
+  return clients_count[second].get() < clients_count[first].get() ? second : first;
+}
+
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef REST_CPP_DISPATCHER_POWEROFTWO_H
+#define REST_CPP_DISPATCHER_POWEROFTWO_H
+
+#include "../dispatcher.h"
+
+namespace REST {
+
+namespace Dispatchers {
+
+/**
+ * Picks two random Workers and selects the one with less
+ * connections ("power of two choices"). Unlike LeastConnections
+ * it does not scan every Worker, yet keeps load almost as even.
+ */
+class PowerOfTwo final : public Dispatcher {
+  public:
+    PowerOfTwo(int workers_count, int sc) : Dispatcher(workers_count, sc) {};
+
+  private:
+    int next_worker_id();
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+#include "workstealing.h"
+
+namespace REST {
+
+namespace Dispatchers {
+
+WorkStealing::WorkStealing(int workers_count, int sc) : Dispatcher(workers_count, sc), last_worker_id(0) {
+  for (auto& worker : workers)
+    worker->share(&workers);
+}
+
+int WorkStealing::next_worker_id() {
+  return last_worker_id++ % workers_count;
+}
+
+void WorkStealing::dispatched(int worker_id) {
+  if (!workers[worker_id]->is_busy())
+    return;
+
+  // client would wait for busy worker, wake up idle one to steal it
+  for (int i = 1; i < workers_count; i++) {
+    auto& worker = workers[(worker_id + i) % workers_count];
+    if (!worker->is_busy() && worker->nudge())
+      return;
+  }
+}
+
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef REST_CPP_DISPATCHER_WORKSTEALING_H
+#define REST_CPP_DISPATCHER_WORKSTEALING_H
+
+#include <atomic>
+#include "../dispatcher.h"
+
+namespace REST {
+
+namespace Dispatchers {
+
+/**
+ * Selects next Worker in order, like RoundRobin, but lets idle
+ * Workers take clients still waiting in queues of busy ones,
+ * so client accepted just before slow request is served by
+ * another Worker instead of waiting for it.
+ *
+ * Idle Worker takes half of queue of busy one, starting with
+ * clients waiting longest (queue is FIFO, its head is the only
+ * end clients can be taken from). Only clients which were not
+ * adopted yet may be stolen - connection, once Worker serves it,
+ * stays with that Worker, so long keep-alive connections are not
+ * rebalanced.
+ */
+class WorkStealing final : public Dispatcher {
+  public:
+    WorkStealing(int workers_count, int sc);
+
+  private:
+    int next_worker_id();
+    void dispatched(int worker_id);
+
+    std::atomic<unsigned int> last_worker_id;
+};
+
+}
+
+}
+
+#endif
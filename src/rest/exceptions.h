@@ -16,6 +16,7 @@ namespace REST {
   CREATE(AddressResolvingError, ServerError, "Cannot resolve address");
   CREATE(SocketCreationError, ServerError, "Cannot create socket");
   CREATE(PortInUseError, ServerError, "Port is already in use");
+  CREATE(QueueFullError, ServerError, "Worker queue is full");
 
   namespace HTTP {
     CREATE(Error, Exception, "Unknown HTTP protocol error");
@@ -25,6 +26,7 @@ namespace REST {
     ERROR(MethodNotAllowed, 405, "Method Not Allowed");
     ERROR(InternalServerError, 500, "Internal Server Error");
     ERROR(NotImplemented, 501, "Not Implemented");
+    ERROR(ServiceUnavailable, 503, "Service Unavailable");
   }
 }
 
@@ -4,7 +4,7 @@ namespace REST {
 namespace Features {
 
 void Authorization::feature_push() {
-  auto auth_header = request->headers.find("Authorization");
+  auto auth_header = request->headers.find(Header::AUTHORIZATION);
   if (auth_header != request->headers.end()) {
     if (auth_header->second.find("Basic") == 0) {
       std::string decoded = Utils::base64_decode(auth_header->second.substr(auth_header->second.find(" ")+1));
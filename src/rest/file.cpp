@@ -0,0 +1,46 @@
+#include "file.h"
+#include "utils.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+namespace REST {
+
+File::shared File::open(std::string const& path) {
+  int handle = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (handle == -1)
+    return nullptr;
+
+  struct stat info;
+  if (fstat(handle, &info) == -1 || !S_ISREG(info.st_mode)) {
+    close(handle);
+    return nullptr;
+  }
+
+  return shared(new File(handle, info));
+}
+
+File::File(int h, struct stat const& info) :
+  handle(h), size(info.st_size), modified(info.st_mtime), device(info.st_dev), inode(info.st_ino) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "\"%lx-%llx\"", (unsigned long) modified, (unsigned long long) size);
+
+  etag = buffer;
+  last_modified = Utils::rfc1123_datetime(modified);
+}
+
+File::~File() {
+  close(handle);
+}
+
+bool File::is_current(std::string const& path) const {
+  struct stat info;
+  if (stat(path.c_str(), &info) == -1)
+    return false;
+
+  return info.st_dev == device && info.st_ino == inode &&
+    info.st_size == size && info.st_mtime == modified;
+}
+
+}
@@ -0,0 +1,50 @@
+#ifndef REST_CPP_FILE_H
+#define REST_CPP_FILE_H
+
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace REST {
+
+/**
+ * File is regular file opened for reading, together with what
+ * its stat() said when it was opened. Descriptor is closed when
+ * last reference is gone, so file queued for sending stays open
+ * even if FileCache dropped it meanwhile.
+ *
+ * @see FileCache
+ */
+class File final {
+
+  public:
+    typedef std::shared_ptr<File> shared;
+
+    //! nullptr unless `path` is regular file which can be read
+    static shared open(std::string const& path);
+
+    ~File();
+
+    File(File const&) = delete;
+    File& operator=(File const&) = delete;
+
+    //! whether file at `path` is still the one which was opened
+    bool is_current(std::string const& path) const;
+
+    int handle;
+    off_t size;
+    time_t modified;
+    std::string etag;
+    std::string last_modified;
+
+  private:
+    File(int handle, struct stat const& info);
+
+    dev_t device;
+    ino_t inode;
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "file_cache.h"
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace REST {
+
+#ifdef __linux__
+static const uint32_t WATCHED_EVENTS = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+  IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+#endif
+
+FileCache::FileCache(size_t c) : capacity(c) {
+#ifdef __linux__
+  notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileCache::~FileCache() {
+  if (notify != -1)
+    close(notify);
+}
+
+static std::string directory_of(std::string const& path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+File::shared FileCache::get(std::string const& path) {
+  std::string directory = directory_of(path);
+  bool watched = false;
+  size_t changes = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    update();
+
+    auto item = items.find(path);
+    if (item != items.end()) {
+      // without notifications file has to be checked every time
+      if (notify != -1 || item->second.file->is_current(path)) {
+        order.splice(order.begin(), order, item->second.position);
+        return item->second.file;
+      }
+
+      remove(path);
+    }
+
+    // directory is watched before file is opened, so no change is missed
+    if (notify != -1 && watch(directory)) {
+      watched = true;
+      changes = directories[directory].changes;
+    }
+  }
+
+  File::shared file = File::open(path);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (notify != -1) {
+    if (!watched)
+      return file;
+
+    // file opened while its directory changed may be stale already,
+    // it is good enough for this request, but it is not kept
+    update();
+    auto watched_directory = directories.find(directory);
+    if (watched_directory->second.changes != changes || items.count(path)) {
+      release(directory);
+      return file;
+    }
+  } else {
+    if (file == nullptr || items.count(path))
+      return file;
+  }
+
+  order.push_front(path);
+  items[path] = Item { file, order.begin() };
+
+  while (items.size() > capacity)
+    remove(order.back());
+
+  return file;
+}
+
+void FileCache::update() {
+#ifdef __linux__
+  if (notify == -1)
+    return;
+
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  while (true) {
+    ssize_t length = read(notify, buffer, sizeof(buffer));
+    if (length <= 0)
+      return;
+
+    for (char* position = buffer; position < buffer + length; ) {
+      struct inotify_event const* event = reinterpret_cast<struct inotify_event const*>(position);
+      position += sizeof(struct inotify_event) + event->len;
+
+      // some events were lost, nothing can be trusted
+      if (event->mask & IN_Q_OVERFLOW) {
+        for (auto& watched : directories)
+          watched.second.changes++;
+        while (!order.empty())
+          remove(order.back());
+        continue;
+      }
+
+      auto found = watches.find(event->wd);
+      if (found == watches.end())
+        continue;
+
+      // dropping files may stop watching directory
+      std::string directory = found->second;
+      Directory& watched = directories[directory];
+      watched.changes++;
+
+      // directory is gone, so is its watch - files being opened
+      // still hold the entry, they will not be cached
+      if (event->mask & IN_IGNORED) {
+        watches.erase(found);
+        watched.watch = -1;
+      }
+
+      if (event->len > 0)
+        remove(directory + "/" + event->name);
+      else
+        forget(directory);
+    }
+  }
+#endif
+}
+
+bool FileCache::watch(std::string const& directory) {
+#ifdef __linux__
+  auto watched = directories.find(directory);
+  if (watched != directories.end() && watched->second.watch != -1) {
+    watched->second.files++;
+    return true;
+  }
+
+  // watch of removed directory is gone, files still being opened
+  // there hold its entry - nothing is cached until they are done
+  if (watched != directories.end())
+    return false;
+
+  int watch = inotify_add_watch(notify, directory.c_str(), WATCHED_EVENTS);
+  if (watch == -1)
+    return false;
+
+  watches[watch] = directory;
+  directories[directory] = Directory { watch, 1, 0 };
+  return true;
+#else
+  return false;
+#endif
+}
+
+void FileCache::release(std::string const& directory) {
+#ifdef __linux__
+  auto watched = directories.find(directory);
+  if (watched == directories.end() || --watched->second.files > 0)
+    return;
+
+  if (watched->second.watch != -1) {
+    inotify_rm_watch(notify, watched->second.watch);
+    watches.erase(watched->second.watch);
+  }
+  directories.erase(watched);
+#endif
+}
+
+void FileCache::remove(std::string const& path) {
+  auto item = items.find(path);
+  if (item == items.end())
+    return;
+
+  // path may be the key which is erased
+  std::string directory = directory_of(path);
+  order.erase(item->second.position);
+  items.erase(item);
+  release(directory);
+}
+
+void FileCache::forget(std::string const& directory) {
+  std::string prefix = directory + "/";
+
+  for (auto item = items.begin(); item != items.end(); ) {
+    auto current = item++;
+    if (current->first.compare(0, prefix.size(), prefix) == 0)
+      remove(current->first);
+  }
+}
+
+}
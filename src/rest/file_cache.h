@@ -0,0 +1,82 @@
+#ifndef REST_CPP_FILE_CACHE_H
+#define REST_CPP_FILE_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "file.h"
+
+namespace REST {
+
+/**
+ * FileCache keeps last `capacity` files open, together with
+ * their stat() results, so serving them again costs no syscalls
+ * but sending itself. Missing files are remembered as well.
+ *
+ * On Linux directories of cached files are watched with inotify
+ * and files are dropped as soon as they change. Watch is removed
+ * when no file of its directory is cached any more. Elsewhere
+ * every cached file is checked with stat() before it is reused
+ * and missing files are not remembered.
+ *
+ * FileCache is shared by all Workers. Files are opened without
+ * holding its lock, so Workers do not wait for each other's disk.
+ *
+ * @see StaticFiles
+ */
+class FileCache final {
+
+  public:
+    FileCache(size_t capacity);
+    ~FileCache();
+
+    FileCache(FileCache const&) = delete;
+    FileCache& operator=(FileCache const&) = delete;
+
+    //! file at `path`, nullptr if there is none
+    File::shared get(std::string const& path);
+
+  private:
+    struct Item {
+      File::shared file;
+      std::list<std::string>::iterator position;
+    };
+
+    /**
+     * Watched directory. `files` counts its cached files and files
+     * being opened, `changes` counts its events, so file opened
+     * while directory changed is not cached.
+     */
+    struct Directory {
+      int watch;
+      size_t files;
+      size_t changes;
+    };
+
+    //! drops files changed since last time
+    void update();
+    //! watches `directory` and counts one more file in it
+    bool watch(std::string const& directory);
+    //! counts one file of `directory` less, stops watching it when there are none
+    void release(std::string const& directory);
+    void remove(std::string const& path);
+    //! drops every file in `directory`
+    void forget(std::string const& directory);
+
+    std::mutex mutex;
+    size_t capacity;
+
+    //! most recently used first
+    std::list<std::string> order;
+    std::unordered_map<std::string, Item> items;
+
+    int notify = -1;
+    std::unordered_map<int, std::string> watches;
+    std::unordered_map<std::string, Directory> directories;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "header.h"
+
+#include <strings.h>
+
+namespace REST {
+
+static const StringView NAMES[Header::COUNT] = {
+  "Content-Length",
+  "Content-Type",
+  "Connection",
+  "Host",
+  "Authorization",
+  "Accept-Encoding",
+  "Date",
+  "Server",
+  "Range",
+  "If-Range",
+  "If-None-Match",
+  "If-Modified-Since",
+  "Content-Encoding",
+  "Accept"
+};
+
+Header::Known Header::resolve(StringView const& name) {
+  Known candidate;
+
+  // names differ in length mostly, compare at most two of them
+  switch (name.size()) {
+    case 4:
+      candidate = (name[0] | 0x20) == 'h' ? HOST : DATE;
+      break;
+    case 5:
+      candidate = RANGE;
+      break;
+    case 6:
+      candidate = (name[0] | 0x20) == 'a' ? ACCEPT : SERVER;
+      break;
+    case 8:
+      candidate = IF_RANGE;
+      break;
+    case 10:
+      candidate = CONNECTION;
+      break;
+    case 12:
+      candidate = CONTENT_TYPE;
+      break;
+    case 13:
+      candidate = (name[0] | 0x20) == 'a' ? AUTHORIZATION : IF_NONE_MATCH;
+      break;
+    case 14:
+      candidate = CONTENT_LENGTH;
+      break;
+    case 15:
+      candidate = ACCEPT_ENCODING;
+      break;
+    case 16:
+      candidate = CONTENT_ENCODING;
+      break;
+    case 17:
+      candidate = IF_MODIFIED_SINCE;
+      break;
+    default:
+      return UNKNOWN;
+  }
+
+  return equals(name, NAMES[candidate]) ? candidate : UNKNOWN;
+}
+
+StringView Header::name(Known header) {
+  return header < COUNT ? NAMES[header] : StringView();
+}
+
+bool Header::equals(StringView const& a, StringView const& b) {
+  return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef REST_CPP_HEADER_H
+#define REST_CPP_HEADER_H
+
+#include "string_view.h"
+
+namespace REST {
+
+/**
+ * Header names are case-insensitive. Headers used by the library
+ * itself are resolved once, when header is added, and kept in
+ * fixed slots of Request and Response headers, so they are found
+ * without comparing names.
+ */
+class Header final {
+
+  public:
+    enum Known {
+      CONTENT_LENGTH,
+      CONTENT_TYPE,
+      CONNECTION,
+      HOST,
+      AUTHORIZATION,
+      ACCEPT_ENCODING,
+      DATE,
+      SERVER,
+      RANGE,
+      IF_RANGE,
+      IF_NONE_MATCH,
+      IF_MODIFIED_SINCE,
+      CONTENT_ENCODING,
+      ACCEPT,
+      COUNT,
+      UNKNOWN = COUNT
+    };
+
+    //! known header of given name, UNKNOWN for any other one
+    static Known resolve(StringView const& name);
+    static StringView name(Known header);
+
+    static bool equals(StringView const& a, StringView const& b);
+};
+
+}
+
+#endif
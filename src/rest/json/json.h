@@ -398,11 +398,9 @@ public:
 #include <vector>
 #include <exception>
 
-#ifndef JSON_USE_CPPTL_SMALLMAP
+#include <cstddef>
 #include <map>
-#else
-#include <cpptl/smallmap.h>
-#endif
+#include <utility>
 #ifdef JSON_USE_CPPTL
 #include <cpptl/forwards.h>
 #endif
@@ -626,11 +624,72 @@ private:
   };
 
 public:
-#ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
-#else
-  typedef CppTL::SmallMap<CZString, Value> ObjectValues;
-#endif // ifndef JSON_USE_CPPTL_SMALLMAP
+  /** \brief Members of object or items of array, sorted by key.
+   *
+   * Members are kept in flat sorted array of pointers, so lookup is binary
+   * search and iteration walks contiguous memory. Every member, the array
+   * and ObjectValues itself are allocated from arena of current
+   * REST::Arena::Scope (or from heap if there is none), so whole tree of
+   * request is released together with arena chunk it was built in.
+   *
+   * Members do not move when others are inserted, so references to them
+   * stay valid; iterators do not.
+   */
+  class ObjectValues {
+  public:
+    typedef std::pair<const CZString, Value> value_type;
+
+    class iterator {
+    public:
+      iterator() : item_(0) {}
+      explicit iterator(value_type* const* item) : item_(item) {}
+
+      value_type& operator*() const { return **item_; }
+      value_type* operator->() const { return *item_; }
+      iterator& operator++() { ++item_; return *this; }
+      iterator& operator--() { --item_; return *this; }
+      bool operator==(iterator const& other) const { return item_ == other.item_; }
+      bool operator!=(iterator const& other) const { return item_ != other.item_; }
+      std::ptrdiff_t operator-(iterator const& other) const { return item_ - other.item_; }
+
+    private:
+      friend class ObjectValues;
+      value_type* const* item_;
+    };
+    typedef iterator const_iterator;
+
+    ObjectValues();
+    ObjectValues(ObjectValues const& other);
+    ~ObjectValues();
+
+    static void* operator new(size_t size);
+    static void operator delete(void* pointer);
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    iterator begin() const { return iterator(items_); }
+    iterator end() const { return iterator(items_ + size_); }
+
+    void clear();
+    iterator find(CZString const& key) const;
+    //! first member not less than `key`, checks last member first, as most of them are appended
+    iterator lower_bound(CZString const& key) const;
+    //! inserts `value` before `position`, which has to keep members sorted
+    iterator insert(iterator position, value_type const& value);
+    void erase(iterator position);
+    void erase(CZString const& key);
+    Value& operator[](CZString const& key);
+
+    bool operator==(ObjectValues const& other) const;
+    bool operator<(ObjectValues const& other) const;
+
+  private:
+    ObjectValues& operator=(ObjectValues const&);
+
+    value_type** items_;
+    size_t size_;
+    size_t capacity_;
+  };
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
 public:
@@ -0,0 +1,676 @@
+#include "json_document.h"
+#include "json_writer.h"
+#include "scanner.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace REST {
+
+const size_t JsonDocument::MAX_DEPTH;
+const uint32_t JsonDocument::NONE;
+
+static bool is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+//! every bit set from first quote of pair to the one before its second quote
+static uint64_t prefix_xor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+/**
+ * Characters escaped by backslashes - odd ones of every run of
+ * backslashes, counted from its start, and character following
+ * run of odd length (escape of previous block carries over).
+ */
+static uint64_t find_escaped(uint64_t backslashes, uint64_t& carry) {
+  const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+  backslashes &= ~carry;
+  uint64_t follows_escape = backslashes << 1 | carry;
+  uint64_t odd_starts = backslashes & ~EVEN_BITS & ~follows_escape;
+
+  unsigned long long even_starts;
+  carry = __builtin_uaddll_overflow(odd_starts, backslashes, &even_starts);
+
+  return (EVEN_BITS ^ (even_starts << 1)) & follows_escape;
+}
+
+static void append_utf8(unsigned int code, std::string& output) {
+  if (code < 0x80) {
+    output += static_cast<char>(code);
+  } else
+  if (code < 0x800) {
+    output += static_cast<char>(0xc0 | (code >> 6));
+    output += static_cast<char>(0x80 | (code & 0x3f));
+  } else
+  if (code < 0x10000) {
+    output += static_cast<char>(0xe0 | (code >> 12));
+    output += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+    output += static_cast<char>(0x80 | (code & 0x3f));
+  } else {
+    output += static_cast<char>(0xf0 | (code >> 18));
+    output += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+    output += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+    output += static_cast<char>(0x80 | (code & 0x3f));
+  }
+}
+
+static bool parse_hex(const char* p, const char* end, unsigned int& code) {
+  if (end - p < 4)
+    return false;
+
+  code = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = p[i];
+    code <<= 4;
+    if (c >= '0' && c <= '9')
+      code |= c - '0';
+    else if (c >= 'a' && c <= 'f')
+      code |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      code |= c - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
+void JsonDocument::reset(const char* d, size_t s, Arena* a, BodyFormat::Type f) {
+  data = d;
+  length = s;
+  format = f;
+  text.clear();
+  arena = a;
+  owner = std::this_thread::get_id();
+
+  structurals.clear();
+  jumps.clear();
+  indexed = valid = materialized = false;
+  decoded = Json::Value();
+}
+
+bool JsonDocument::index() const {
+  if (indexed)
+    return valid;
+
+  indexed = true;
+
+  if (format != BodyFormat::JSON) {
+    Json::Value value;
+    if (BodyFormat::read(format, data, length, value))
+      JsonWriter::write(value, text);
+
+    // invalid document is empty one
+    data = text.data();
+    length = text.size();
+    format = BodyFormat::JSON;
+  }
+
+  if (length == 0 || length >= NONE)
+    return false;
+
+  // index grows by blocks, every byte of block may be structural one
+  structurals.resize(length / 4 + 64);
+  size_t count = 0;
+
+  uint64_t escape_carry = 0;
+  uint64_t in_string_carry = 0;
+  uint64_t scalar_carry = 0;
+  char tail[64];
+
+  for (size_t offset = 0; offset < length; offset += 64) {
+    const char* block_data = data + offset;
+
+    // last block is padded with whitespace
+    if (length - offset < 64) {
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, block_data, length - offset);
+      block_data = tail;
+    }
+
+    Scanner::Block block;
+    Scanner::classify(block_data, block);
+
+    uint64_t quotes = block.quotes & ~find_escaped(block.backslashes, escape_carry);
+    uint64_t in_string = prefix_xor(quotes) ^ in_string_carry;
+    in_string_carry = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+    // numbers and literals start where something else than them ends
+    uint64_t scalars = ~(block.operators | block.whitespace | quotes | in_string);
+    uint64_t scalar_starts = scalars & ~(scalars << 1 | scalar_carry);
+    scalar_carry = scalars >> 63;
+
+    if (structurals.size() - count < 64)
+      structurals.resize(structurals.size() * 2);
+
+    uint64_t bits = (block.operators & ~in_string) | (quotes & in_string) | scalar_starts;
+    uint32_t* position = structurals.data() + count;
+    while (bits) {
+      *position++ = static_cast<uint32_t>(offset + __builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+    count = position - structurals.data();
+  }
+
+  structurals.resize(count);
+
+  // unterminated string
+  if (in_string_carry || structurals.empty())
+    return false;
+
+  structurals.push_back(static_cast<uint32_t>(length));
+  jumps.assign(structurals.size(), NONE);
+
+  std::vector<uint32_t> open;
+  for (size_t i = 0; i + 1 < structurals.size(); i++) {
+    char c = data[structurals[i]];
+
+    if (c == '{' || c == '[') {
+      if (open.size() == MAX_DEPTH)
+        return false;
+      open.push_back(i);
+    } else
+    if (c == '}' || c == ']') {
+      if (open.empty() || data[structurals[open.back()]] != (c == '}' ? '{' : '['))
+        return false;
+      jumps[open.back()] = i;
+      open.pop_back();
+    }
+  }
+
+  // single value, nothing after it
+  valid = open.empty() && skip(0) == structurals.size() - 1;
+  return valid;
+}
+
+size_t JsonDocument::skip(size_t index) const {
+  return jumps[index] != NONE ? jumps[index] + 1 : index + 1;
+}
+
+const char* JsonDocument::value_end(size_t index) const {
+  const char* begin = data + structurals[index];
+  const char* end = data + structurals[index + 1];
+
+  while (end > begin && is_whitespace(end[-1]))
+    end--;
+  return end;
+}
+
+JsonDocument::Element JsonDocument::root() const {
+  return index() ? Element(this, 0) : Element();
+}
+
+bool JsonDocument::is_valid() const {
+  return index();
+}
+
+Json::Value& JsonDocument::value() {
+  static_cast<JsonDocument const*>(this)->value();
+  return decoded;
+}
+
+Json::Value const& JsonDocument::value() const {
+  if (!materialized) {
+    materialized = true;
+
+    // only owner of arena may allocate from it
+    Arena::Scope scope(std::this_thread::get_id() == owner ? arena : nullptr);
+    bool decoded_valid = format == BodyFormat::JSON
+      ? index() && decode(0, decoded)
+      : BodyFormat::read(format, data, length, decoded);
+    if (!decoded_valid)
+      decoded = Json::Value();
+  }
+
+  return decoded;
+}
+
+bool JsonDocument::decode(size_t index, Json::Value& value) const {
+  switch (data[structurals[index]]) {
+    case '{': {
+      value = Json::Value(Json::objectValue);
+
+      size_t i = index + 1;
+      if (data[structurals[i]] == '}')
+        return true;
+
+      // keys are decoded first and values in order of keys, so every
+      // member is appended to sorted members of Json::Value
+      std::vector<std::pair<std::string, size_t>> members;
+      while (true) {
+        members.emplace_back(std::string(), i + 2);
+        if (data[structurals[i]] != '"' || data[structurals[i + 1]] != ':' || !decode_string(i, members.back().first))
+          return false;
+
+        size_t next = skip(i + 2);
+        if (data[structurals[next]] != ',') {
+          if (next != jumps[index])
+            return false;
+          break;
+        }
+        i = next + 1;
+      }
+
+      // stable, so last of duplicate keys wins
+      std::stable_sort(members.begin(), members.end(),
+        [] (std::pair<std::string, size_t> const& a, std::pair<std::string, size_t> const& b) { return a.first < b.first; });
+
+      for (auto const& member : members)
+        if (!decode(member.second, value[member.first]))
+          return false;
+      return true;
+    }
+
+    case '[': {
+      value = Json::Value(Json::arrayValue);
+
+      size_t i = index + 1;
+      if (data[structurals[i]] == ']')
+        return true;
+
+      for (Json::ArrayIndex count = 0; ; count++) {
+        if (!decode(i, value[count]))
+          return false;
+
+        size_t next = skip(i);
+        if (data[structurals[next]] != ',')
+          return next == jumps[index];
+        i = next + 1;
+      }
+    }
+
+    case '"': {
+      const char* begin = data + structurals[index] + 1;
+      const char* end = value_end(index) - 1;
+
+      // strings without escapes are not copied twice
+      if (end >= begin && *end == '"' && memchr(begin, '\\', end - begin) == nullptr) {
+        value = Json::Value(begin, end);
+        return true;
+      }
+
+      std::string decoded;
+      if (!decode_string(index, decoded))
+        return false;
+      value = Json::Value(decoded.data(), decoded.data() + decoded.size());
+      return true;
+    }
+
+    case 't':
+    case 'f':
+    case 'n': {
+      StringView literal(data + structurals[index], value_end(index) - data - structurals[index]);
+      if (literal == "true")
+        value = true;
+      else if (literal == "false")
+        value = false;
+      else if (literal == "null")
+        value = Json::Value();
+      else
+        return false;
+      return true;
+    }
+
+    default:
+      return decode_number(index, value);
+  }
+}
+
+bool JsonDocument::decode_string(size_t index, std::string& output) const {
+  const char* p = data + structurals[index];
+  const char* end = value_end(index);
+
+  if (*p != '"' || end - p < 2 || end[-1] != '"')
+    return false;
+
+  p++;
+  end--;
+  output.clear();
+
+  while (p < end) {
+    const char* backslash = static_cast<const char*>(memchr(p, '\\', end - p));
+    if (backslash == nullptr) {
+      output.append(p, end - p);
+      break;
+    }
+
+    output.append(p, backslash - p);
+    p = backslash + 2;
+    if (p > end)
+      return false;
+
+    switch (backslash[1]) {
+      case '"': output += '"'; break;
+      case '\\': output += '\\'; break;
+      case '/': output += '/'; break;
+      case 'b': output += '\b'; break;
+      case 'f': output += '\f'; break;
+      case 'n': output += '\n'; break;
+      case 'r': output += '\r'; break;
+      case 't': output += '\t'; break;
+      case 'u': {
+        unsigned int code;
+        if (!parse_hex(p, end, code))
+          return false;
+        p += 4;
+
+        // surrogate pair
+        if (code >= 0xd800 && code <= 0xdbff) {
+          unsigned int low;
+          if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !parse_hex(p + 2, end, low) || low < 0xdc00 || low > 0xdfff)
+            return false;
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          p += 6;
+        }
+
+        append_utf8(code, output);
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool JsonDocument::decode_number(size_t index, Json::Value& value) const {
+  const char* begin = data + structurals[index];
+  const char* end = value_end(index);
+  const char* p = begin;
+
+  bool negative = p < end && *p == '-';
+  if (negative)
+    p++;
+
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  const char* digits = p;
+  if (p == end || !is_digit(*p) || (*p == '0' && p + 1 < end && is_digit(p[1])))
+    return false;
+  while (p < end && is_digit(*p))
+    p++;
+  const char* digits_end = p;
+
+  if (p < end && *p == '.') {
+    if (++p == end || !is_digit(*p))
+      return false;
+    while (p < end && is_digit(*p))
+      p++;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    if (++p < end && (*p == '+' || *p == '-'))
+      p++;
+    if (p == end || !is_digit(*p))
+      return false;
+    while (p < end && is_digit(*p))
+      p++;
+  }
+
+  if (p != end)
+    return false;
+
+  // integers are kept as integers, unless they do not fit
+  if (digits_end == end) {
+    Json::LargestUInt number = 0;
+    bool overflow = false;
+
+    for (const char* d = digits; d < end && !overflow; d++) {
+      Json::LargestUInt next = number * 10 + (*d - '0');
+      overflow = number > Json::Value::maxLargestUInt / 10 || next < number;
+      number = next;
+    }
+
+    // same types as Json::Reader gives
+    if (!overflow) {
+      if (!negative && number <= static_cast<Json::LargestUInt>(Json::Value::maxInt)) {
+        value = static_cast<Json::LargestInt>(number);
+        return true;
+      }
+      if (!negative) {
+        value = number;
+        return true;
+      }
+      if (number <= static_cast<Json::LargestUInt>(Json::Value::maxLargestInt) + 1) {
+        value = static_cast<Json::LargestInt>(0 - number);
+        return true;
+      }
+    }
+  }
+
+  // strtod needs terminated copy, body is not terminated
+  std::string number(begin, end);
+  value = strtod(number.c_str(), nullptr);
+  return true;
+}
+
+char JsonDocument::Element::first() const {
+  if (document == nullptr)
+    return 0;
+
+  char c = document->data[document->structurals[index]];
+  return c == '}' || c == ']' || c == ',' || c == ':' ? 0 : c;
+}
+
+Json::ValueType JsonDocument::Element::type() const {
+  switch (first()) {
+    case '{': return Json::objectValue;
+    case '[': return Json::arrayValue;
+    case '"': return Json::stringValue;
+    case 't':
+    case 'f': return Json::booleanValue;
+    case 0:
+    case 'n': return Json::nullValue;
+  }
+
+  Json::Value number;
+  return document->decode_number(index, number) ? number.type() : Json::nullValue;
+}
+
+JsonDocument::Element JsonDocument::Element::operator[](StringView const& key) const {
+  if (first() != '{')
+    return Element();
+
+  const char* data = document->data;
+  std::vector<uint32_t> const& structurals = document->structurals;
+  std::string name;
+  Element found;
+
+  // duplicated keys are looked up to the last one, as decode() keeps it
+  for (size_t i = index + 1; data[structurals[i]] == '"' && data[structurals[i + 1]] == ':'; ) {
+    const char* begin = data + structurals[i] + 1;
+    const char* end = document->value_end(i) - 1;
+    if (end < begin || *end != '"')
+      break;
+
+    // escaped names are compared decoded
+    if (memchr(begin, '\\', end - begin) != nullptr) {
+      if (document->decode_string(i, name) && key == name)
+        found = Element(document, i + 2);
+    } else
+    if (key == StringView(begin, end - begin)) {
+      found = Element(document, i + 2);
+    }
+
+    size_t next = document->skip(i + 2);
+    if (data[structurals[next]] != ',')
+      break;
+    i = next + 1;
+  }
+
+  return found;
+}
+
+JsonDocument::Element JsonDocument::Element::operator[](size_t n) const {
+  for (auto item = begin(); item != end(); ++item, n--)
+    if (n == 0)
+      return *item;
+
+  return Element();
+}
+
+size_t JsonDocument::Element::size() const {
+  size_t count = 0;
+  for (auto item = begin(); item != end(); ++item)
+    count++;
+  return count;
+}
+
+JsonDocument::Element::iterator JsonDocument::Element::begin() const {
+  char c = first();
+  if (c != '{' && c != '[')
+    return iterator(nullptr, 0, 0, false);
+
+  return iterator(document, index + 1, document->jumps[index], c == '{');
+}
+
+JsonDocument::Element::iterator JsonDocument::Element::end() const {
+  char c = first();
+  if (c != '{' && c != '[')
+    return iterator(nullptr, 0, 0, false);
+
+  size_t last = document->jumps[index];
+  return iterator(document, last, last, c == '{');
+}
+
+JsonDocument::Element::iterator::iterator(JsonDocument const* d, size_t i, size_t l, bool o) :
+  document(d), index(i), last(l), object(o) {
+  if (document == nullptr || index == last)
+    return;
+
+  // malformed member ends iteration
+  const char* data = document->data;
+  if (object && (data[document->structurals[index]] != '"' || data[document->structurals[index + 1]] != ':'))
+    index = last;
+}
+
+JsonDocument::Element::iterator& JsonDocument::Element::iterator::operator++() {
+  size_t next = document->skip(object ? index + 2 : index);
+
+  if (document->data[document->structurals[next]] != ',')
+    index = last;
+  else
+    *this = iterator(document, next + 1, last, object);
+
+  return *this;
+}
+
+JsonDocument::Element JsonDocument::Element::iterator::operator*() const {
+  return Element(document, object ? index + 2 : index);
+}
+
+std::string JsonDocument::Element::iterator::key() const {
+  std::string name;
+  if (object)
+    document->decode_string(index, name);
+  return name;
+}
+
+StringView JsonDocument::Element::iterator::raw_key() const {
+  if (!object)
+    return StringView();
+
+  const char* begin = document->data + document->structurals[index] + 1;
+  return StringView(begin, document->value_end(index) - 1 - begin);
+}
+
+StringView JsonDocument::Element::raw() const {
+  char c = first();
+  if (c == 0)
+    return StringView();
+
+  const char* begin = document->data + document->structurals[index];
+  if (c == '{' || c == '[')
+    return StringView(begin, document->structurals[document->jumps[index]] + 1 - document->structurals[index]);
+
+  return StringView(begin, document->value_end(index) - begin);
+}
+
+bool JsonDocument::Element::get(std::string& value) const {
+  return first() == '"' && document->decode_string(index, value);
+}
+
+bool JsonDocument::Element::get(Json::LargestInt& value) const {
+  Json::Value number;
+  if (first() == 0 || !document->decode_number(index, number))
+    return false;
+
+  switch (number.type()) {
+    case Json::intValue: value = number.asLargestInt(); break;
+    case Json::uintValue:
+      if (number.asLargestUInt() > static_cast<Json::LargestUInt>(Json::Value::maxLargestInt))
+        return false;
+      value = static_cast<Json::LargestInt>(number.asLargestUInt());
+      break;
+    default:
+      // conversion of double out of range is undefined (NaN is never in range)
+      double real = number.asDouble();
+      if (!(real >= -9223372036854775808.0 && real < 9223372036854775808.0))
+        return false;
+      value = static_cast<Json::LargestInt>(real);
+  }
+  return true;
+}
+
+bool JsonDocument::Element::get(double& value) const {
+  Json::Value number;
+  if (first() == 0 || !document->decode_number(index, number))
+    return false;
+
+  value = number.asDouble();
+  return true;
+}
+
+bool JsonDocument::Element::get(bool& value) const {
+  StringView literal = raw();
+  if (literal != "true" && literal != "false")
+    return false;
+
+  value = literal == "true";
+  return true;
+}
+
+std::string JsonDocument::Element::as_string(std::string const& default_value) const {
+  std::string value;
+  return get(value) ? value : default_value;
+}
+
+Json::LargestInt JsonDocument::Element::as_int(Json::LargestInt default_value) const {
+  Json::LargestInt value = default_value;
+  get(value);
+  return value;
+}
+
+double JsonDocument::Element::as_double(double default_value) const {
+  double value = default_value;
+  get(value);
+  return value;
+}
+
+bool JsonDocument::Element::as_bool(bool default_value) const {
+  bool value = default_value;
+  get(value);
+  return value;
+}
+
+Json::Value JsonDocument::Element::value() const {
+  Json::Value value;
+  if (first() == 0 || !document->decode(index, value))
+    return Json::Value();
+  return value;
+}
+
+}
@@ -0,0 +1,207 @@
+#ifndef REST_CPP_JSON_DOCUMENT_H
+#define REST_CPP_JSON_DOCUMENT_H
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "body_format.h"
+#include "string_view.h"
+#include "json/json.h"
+
+namespace REST {
+
+/**
+ * JsonDocument is JSON request body, which is parsed only as far
+ * as handler looks into it.
+ *
+ * First time document is used, it is indexed: Scanner classifies
+ * it 64 bytes at a time and positions of structural characters
+ * (brackets, colons, commas and starts of values) outside strings
+ * are recorded, together with matching closing bracket of every
+ * opening one. Nothing is decoded yet.
+ *
+ * root() navigates the index on demand - skipping whole object
+ * or array is single jump and only values which are read are
+ * decoded. Json::Value (see value() and operators) is built from
+ * the index once it is needed, and kept.
+ *
+ * Bodies of binary formats (see BodyFormat) are decoded straight
+ * into Json::Value, root() writes them as JSON and indexes that.
+ *
+ * Document refers to request bytes, so it may be used as long as
+ * request exists. Invalid document is null, as is missing one.
+ *
+ * Document converts to Json::Value and forwards its most used
+ * members, so code written for Json::Value request data works
+ * unchanged.
+ */
+class JsonDocument final {
+
+  public:
+    /**
+     * Element is view of one value of document. Element which
+     * is not in document (missing key, index out of bounds or
+     * anything of invalid document) is null one and !exists().
+     */
+    class Element {
+      friend class JsonDocument;
+
+      public:
+        class iterator {
+          friend class Element;
+
+          public:
+            Element operator*() const;
+            iterator& operator++();
+            bool operator==(iterator const& other) const { return index == other.index; }
+            bool operator!=(iterator const& other) const { return index != other.index; }
+
+            //! name of member, when iterating object
+            std::string key() const;
+            //! name of member as it is in document, still escaped
+            StringView raw_key() const;
+
+          private:
+            iterator(JsonDocument const* document, size_t index, size_t last, bool object);
+
+            JsonDocument const* document;
+            size_t index;
+            //! closing bracket
+            size_t last;
+            bool object;
+        };
+
+        Element() : document(nullptr), index(0) {}
+
+        bool exists() const { return document != nullptr; }
+        Json::ValueType type() const;
+
+        //! member `key` of object, the last one when `key` is repeated
+        Element operator[](StringView const& key) const;
+        Element operator[](const char* key) const { return (*this)[StringView(key)]; }
+        Element operator[](std::string const& key) const { return (*this)[StringView(key)]; }
+        //! `index`th item of array
+        Element operator[](size_t index) const;
+        Element operator[](int index) const { return (*this)[static_cast<size_t>(index)]; }
+
+        //! count of items or members, counted by walking them
+        size_t size() const;
+        iterator begin() const;
+        iterator end() const;
+
+        //! value as it is in document (strings are quoted and escaped)
+        StringView raw() const;
+
+        //! reads value of given type, false (and `value` untouched) when it is of other one
+        bool get(std::string& value) const;
+        bool get(Json::LargestInt& value) const;
+        bool get(double& value) const;
+        bool get(bool& value) const;
+
+        bool is_null() const { return type() == Json::nullValue; }
+        std::string as_string(std::string const& default_value = std::string()) const;
+        Json::LargestInt as_int(Json::LargestInt default_value = 0) const;
+        double as_double(double default_value = 0) const;
+        bool as_bool(bool default_value = false) const;
+
+        //! decodes whole value, null when it is not valid
+        Json::Value value() const;
+
+      private:
+        Element(JsonDocument const* d, size_t i) : document(d), index(i) {}
+
+        //! first character of value, 0 if there is no value
+        char first() const;
+
+        JsonDocument const* document;
+        size_t index;
+    };
+
+    JsonDocument() {}
+    JsonDocument(JsonDocument const&) = delete;
+    JsonDocument& operator=(JsonDocument const&) = delete;
+
+    //! document is `size` bytes of `data` in `format`, whose strings are allocated in `arena`
+    void reset(const char* data, size_t size, Arena* arena, BodyFormat::Type format = BodyFormat::JSON);
+
+    //! whole document, navigated on demand
+    Element root() const;
+    //! whether strings and brackets of document are closed, values are checked when they are decoded
+    bool is_valid() const;
+
+    //! document decoded into Json::Value on first use
+    Json::Value& value();
+    Json::Value const& value() const;
+    Json::Value& operator*() { return value(); }
+    Json::Value const& operator*() const { return value(); }
+    Json::Value* operator->() { return &value(); }
+    Json::Value const* operator->() const { return &value(); }
+    operator Json::Value&() { return value(); }
+    operator Json::Value const&() const { return value(); }
+
+    Json::Value& operator[](const char* key) { return value()[key]; }
+    Json::Value& operator[](std::string const& key) { return value()[key]; }
+    Json::Value& operator[](Json::ArrayIndex index) { return value()[index]; }
+    Json::Value& operator[](int index) { return value()[index]; }
+    Json::Value const& operator[](const char* key) const { return value()[key]; }
+    Json::Value const& operator[](std::string const& key) const { return value()[key]; }
+    Json::Value const& operator[](Json::ArrayIndex index) const { return value()[index]; }
+    Json::Value const& operator[](int index) const { return value()[index]; }
+
+    Json::ValueType type() const { return value().type(); }
+    bool isNull() const { return value().isNull(); }
+    bool isObject() const { return value().isObject(); }
+    bool isArray() const { return value().isArray(); }
+    bool isMember(const char* key) const { return value().isMember(key); }
+    bool isMember(std::string const& key) const { return value().isMember(key); }
+    Json::ArrayIndex size() const { return value().size(); }
+    bool empty() const { return value().empty(); }
+    Json::Value::Members getMemberNames() const { return value().getMemberNames(); }
+    Json::Value get(const char* key, Json::Value const& default_value) const { return value().get(key, default_value); }
+    Json::Value get(std::string const& key, Json::Value const& default_value) const { return value().get(key, default_value); }
+    std::string toStyledString() const { return value().toStyledString(); }
+
+    bool operator==(Json::Value const& other) const { return value() == other; }
+    bool operator!=(Json::Value const& other) const { return value() != other; }
+
+    const static size_t MAX_DEPTH = 1000;
+
+  private:
+    const static uint32_t NONE = UINT32_MAX;
+
+    //! builds index, if it is not built yet
+    bool index() const;
+    //! index of first structural after value at `index`
+    size_t skip(size_t index) const;
+    //! end of scalar value at `index`, trailing whitespace excluded
+    const char* value_end(size_t index) const;
+
+    bool decode(size_t index, Json::Value& value) const;
+    bool decode_string(size_t index, std::string& output) const;
+    bool decode_number(size_t index, Json::Value& value) const;
+
+    //! binary document is replaced by JSON written into `text` when it is indexed
+    mutable const char* data = nullptr;
+    mutable size_t length = 0;
+    mutable BodyFormat::Type format = BodyFormat::JSON;
+    mutable std::string text;
+    Arena* arena = nullptr;
+    std::thread::id owner;
+
+    //! positions of structural characters, followed by `length`
+    mutable std::vector<uint32_t> structurals;
+    //! matching closing bracket of every opening one, NONE for others
+    mutable std::vector<uint32_t> jumps;
+    mutable bool indexed = false;
+    mutable bool valid = false;
+
+    mutable Json::Value decoded;
+    mutable bool materialized = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef REST_CPP_JSON_FIELDS_H
+#define REST_CPP_JSON_FIELDS_H
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "json_document.h"
+#include "json_writer.h"
+
+/**
+ * Binds fields of struct to JSON object, so it is written to
+ * response and read from request without building Json::Value:
+ *
+ *     struct Task {
+ *       int id;
+ *       std::string title;
+ *       bool done;
+ *     };
+ *
+ *     REST_JSON_FIELDS(Task, id, title, done)
+ *
+ *     response->json(task);
+ *     request->json(task);
+ *
+ * Macro must be used in namespace of struct. It expands into
+ * writer and reader of struct (found by argument dependent lookup),
+ * names of fields are quoted at compile time. Fields may be numbers,
+ * booleans, strings, std::vector and std::map (with string keys) of
+ * them, Json::Value or other bound structs. Up to 32 fields are
+ * supported.
+ *
+ * Members missing in request are left as they are, unknown ones
+ * are skipped without decoding them.
+ */
+#define REST_JSON_FIELDS(Type, ...) \
+  inline void rest_json_write(Type const& object, std::string& output) { \
+    size_t start = output.size(); \
+    REST_JSON_EXPAND(REST_JSON_EACH(REST_JSON_WRITE_FIELD, Type, __VA_ARGS__)) \
+    output[start] = '{'; \
+    output += '}'; \
+  } \
+  inline bool rest_json_read(REST::JsonDocument::Element const& element, Type& object) { \
+    if (element.type() != Json::objectValue) \
+      return false; \
+    bool valid = true; \
+    for (auto member = element.begin(); member != element.end(); ++member) { \
+      REST::StringView key = member.raw_key(); \
+      REST_JSON_EXPAND(REST_JSON_EACH(REST_JSON_READ_FIELD, Type, __VA_ARGS__)) \
+    } \
+    return valid; \
+  }
+
+//! every field is written with leading comma, first one is replaced by opening brace
+#define REST_JSON_WRITE_FIELD(Type, field) \
+  output.append(",\"" #field "\":", sizeof(#field) + 3); \
+  REST::JsonFields::write(object.field, output);
+
+#define REST_JSON_READ_FIELD(Type, field) \
+  if (key == #field) { \
+    valid = REST::JsonFields::read(*member, object.field) && valid; \
+    continue; \
+  }
+
+#define REST_JSON_EXPAND(x) x
+#define REST_JSON_CONCAT(a, b) REST_JSON_CONCAT_(a, b)
+#define REST_JSON_CONCAT_(a, b) a##b
+#define REST_JSON_COUNT(...) REST_JSON_EXPAND(REST_JSON_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define REST_JSON_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define REST_JSON_EACH(M, T, ...) REST_JSON_EXPAND(REST_JSON_CONCAT(REST_JSON_EACH_, REST_JSON_COUNT(__VA_ARGS__))(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_1(M, T, f) M(T, f)
+#define REST_JSON_EACH_2(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_1(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_3(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_2(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_4(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_3(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_5(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_4(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_6(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_5(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_7(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_6(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_8(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_7(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_9(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_8(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_10(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_9(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_11(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_10(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_12(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_11(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_13(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_12(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_14(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_13(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_15(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_14(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_16(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_15(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_17(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_16(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_18(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_17(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_19(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_18(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_20(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_19(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_21(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_20(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_22(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_21(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_23(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_22(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_24(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_23(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_25(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_24(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_26(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_25(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_27(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_26(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_28(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_27(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_29(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_28(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_30(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_29(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_31(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_30(M, T, __VA_ARGS__))
+#define REST_JSON_EACH_32(M, T, f, ...) M(T, f) REST_JSON_EXPAND(REST_JSON_EACH_31(M, T, __VA_ARGS__))
+
+namespace REST {
+
+/**
+ * Writers and readers of values of bound fields.
+ *
+ * @see REST_JSON_FIELDS
+ */
+namespace JsonFields {
+
+// containers of containers find each other
+template <class T> void write(std::vector<T> const& values, std::string& output);
+template <class T> void write(std::map<std::string, T> const& values, std::string& output);
+template <class T> bool read(JsonDocument::Element const& element, std::vector<T>& values);
+template <class T> bool read(JsonDocument::Element const& element, std::map<std::string, T>& values);
+
+inline void write(bool value, std::string& output) {
+  output += value ? "true" : "false";
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+write(T value, std::string& output) {
+  JsonWriter::write_integer(static_cast<Json::LargestInt>(value), output);
+}
+
+template <class T>
+typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+write(T value, std::string& output) {
+  JsonWriter::write_integer(static_cast<Json::LargestUInt>(value), output);
+}
+
+inline void write(double value, std::string& output) {
+  JsonWriter::write_double(value, output);
+}
+
+inline void write(float value, std::string& output) {
+  JsonWriter::write_double(value, output);
+}
+
+inline void write(std::string const& value, std::string& output) {
+  JsonWriter::write_string(value.data(), value.size(), output);
+}
+
+inline void write(const char* value, std::string& output) {
+  JsonWriter::write_string(value, strlen(value), output);
+}
+
+inline void write(Json::Value const& value, std::string& output) {
+  // JsonWriter ends document with new line
+  JsonWriter::write(value, output);
+  output.resize(output.size() - 1);
+}
+
+template <class T>
+auto write(T const& value, std::string& output) -> decltype(rest_json_write(value, output)) {
+  rest_json_write(value, output);
+}
+
+template <class T>
+void write(std::vector<T> const& values, std::string& output) {
+  output += '[';
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i > 0)
+      output += ',';
+    write(values[i], output);
+  }
+  output += ']';
+}
+
+template <class T>
+void write(std::map<std::string, T> const& values, std::string& output) {
+  output += '{';
+  for (auto value = values.begin(); value != values.end(); ++value) {
+    if (value != values.begin())
+      output += ',';
+    write(value->first, output);
+    output += ':';
+    write(value->second, output);
+  }
+  output += '}';
+}
+
+inline bool read(JsonDocument::Element const& element, bool& value) {
+  return element.get(value);
+}
+
+//! integral number which fits into T, fractions and numbers out of its range are refused
+template <class T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type
+read(JsonDocument::Element const& element, T& value) {
+  typedef std::numeric_limits<T> limits;
+  Json::Value number = element.value();
+
+  switch (number.type()) {
+    case Json::intValue: {
+      Json::LargestInt integer = number.asLargestInt();
+      if (limits::is_signed
+          ? integer < static_cast<Json::LargestInt>(limits::min()) || integer > static_cast<Json::LargestInt>(limits::max())
+          : integer < 0 || static_cast<Json::LargestUInt>(integer) > static_cast<Json::LargestUInt>(limits::max()))
+        return false;
+      value = static_cast<T>(integer);
+      return true;
+    }
+    case Json::uintValue: {
+      Json::LargestUInt integer = number.asLargestUInt();
+      if (integer > static_cast<Json::LargestUInt>(limits::max()))
+        return false;
+      value = static_cast<T>(integer);
+      return true;
+    }
+    case Json::realValue: {
+      // T holds [-2^digits, 2^digits) when signed, [0, 2^digits) otherwise
+      double real = number.asDouble();
+      double bound = std::ldexp(1.0, limits::digits);
+      if (real != std::floor(real) || real >= bound || real < (limits::is_signed ? -bound : 0))
+        return false;
+      value = limits::is_signed ? static_cast<T>(static_cast<Json::LargestInt>(real))
+                                : static_cast<T>(static_cast<Json::LargestUInt>(real));
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+read(JsonDocument::Element const& element, T& value) {
+  double number;
+  if (!element.get(number))
+    return false;
+
+  value = static_cast<T>(number);
+  return true;
+}
+
+inline bool read(JsonDocument::Element const& element, std::string& value) {
+  return element.get(value);
+}
+
+inline bool read(JsonDocument::Element const& element, Json::Value& value) {
+  value = element.value();
+  return true;
+}
+
+template <class T>
+auto read(JsonDocument::Element const& element, T& value) -> decltype(rest_json_read(element, value)) {
+  return rest_json_read(element, value);
+}
+
+template <class T>
+bool read(JsonDocument::Element const& element, std::vector<T>& values) {
+  if (element.type() != Json::arrayValue)
+    return false;
+
+  bool valid = true;
+  values.clear();
+  for (auto item = element.begin(); item != element.end(); ++item) {
+    values.emplace_back();
+    valid = read(*item, values.back()) && valid;
+  }
+  return valid;
+}
+
+template <class T>
+bool read(JsonDocument::Element const& element, std::map<std::string, T>& values) {
+  if (element.type() != Json::objectValue)
+    return false;
+
+  bool valid = true;
+  values.clear();
+  for (auto member = element.begin(); member != element.end(); ++member)
+    valid = read(*member, values[member.key()]) && valid;
+  return valid;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include "json_writer.h"
+#include "scanner.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace REST {
+
+size_t JsonWriter::SEGMENT_SIZE = 262144;
+
+static const char DIGIT_PAIRS[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+void JsonWriter::write(Json::Value const& value, std::string& output, Flush const& flush) {
+  JsonWriter writer(output, flush);
+  writer.write_value(value);
+  output += '\n';
+}
+
+void JsonWriter::write_integer(Json::LargestUInt value, std::string& output) {
+  // digits are written from the end, two at a time
+  char buffer[24];
+  char* position = buffer + sizeof(buffer);
+
+  while (value >= 100) {
+    unsigned pair = static_cast<unsigned>(value % 100) * 2;
+    value /= 100;
+    *--position = DIGIT_PAIRS[pair + 1];
+    *--position = DIGIT_PAIRS[pair];
+  }
+
+  if (value >= 10) {
+    unsigned pair = static_cast<unsigned>(value) * 2;
+    *--position = DIGIT_PAIRS[pair + 1];
+    *--position = DIGIT_PAIRS[pair];
+  } else {
+    *--position = static_cast<char>('0' + value);
+  }
+
+  output.append(position, buffer + sizeof(buffer) - position);
+}
+
+void JsonWriter::write_integer(Json::LargestInt value, std::string& output) {
+  if (value >= 0)
+    return write_integer(static_cast<Json::LargestUInt>(value), output);
+
+  // negated in unsigned arithmetic, so minimum value does not overflow
+  output += '-';
+  write_integer(static_cast<Json::LargestUInt>(0) - static_cast<Json::LargestUInt>(value), output);
+}
+
+void JsonWriter::write_double(double value, std::string& output) {
+  // NaN and infinities as Json::FastWriter writes them
+  if (std::isnan(value)) {
+    output += "null";
+    return;
+  }
+
+  if (std::isinf(value)) {
+    output += value < 0 ? "-1e+9999" : "1e+9999";
+    return;
+  }
+
+  // most values are read back exactly from 15 or 16 digits already,
+  // 17 are always enough
+  char buffer[32];
+  int length = 0;
+
+  for (int precision = 15; precision <= 17; precision++) {
+    length = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (precision == 17 || strtod(buffer, nullptr) == value)
+      break;
+  }
+
+  // decimal separator of current locale
+  for (int i = 0; i < length; i++)
+    if (buffer[i] == ',')
+      buffer[i] = '.';
+
+  output.append(buffer, length);
+}
+
+void JsonWriter::write_string(const char* data, size_t size, std::string& output) {
+  const char* end = data + size;
+
+  output += '"';
+
+  while (data < end) {
+    const char* special = Scanner::find_escape(data, end);
+    output.append(data, special - data);
+
+    if (special == end)
+      break;
+
+    switch (*special) {
+      case '"':  output += "\\\""; break;
+      case '\\': output += "\\\\"; break;
+      case '\b': output += "\\b"; break;
+      case '\f': output += "\\f"; break;
+      case '\n': output += "\\n"; break;
+      case '\r': output += "\\r"; break;
+      case '\t': output += "\\t"; break;
+      default: {
+        char escaped[6] = { '\\', 'u', '0', '0', HEX_DIGITS[(*special >> 4) & 0xf], HEX_DIGITS[*special & 0xf] };
+        output.append(escaped, sizeof(escaped));
+      }
+    }
+
+    data = special + 1;
+  }
+
+  output += '"';
+}
+
+void JsonWriter::check_segment() {
+  if (flush && output.size() >= SEGMENT_SIZE)
+    flush(output);
+}
+
+void JsonWriter::write_value(Json::Value const& value) {
+  switch (value.type()) {
+    case Json::nullValue:
+      output += "null";
+      break;
+
+    case Json::intValue:
+      write_integer(value.asLargestInt(), output);
+      break;
+
+    case Json::uintValue:
+      write_integer(value.asLargestUInt(), output);
+      break;
+
+    case Json::realValue:
+      write_double(value.asDouble(), output);
+      break;
+
+    case Json::stringValue: {
+      const char* begin;
+      const char* end;
+      if (value.getString(&begin, &end))
+        write_string(begin, end - begin, output);
+      break;
+    }
+
+    case Json::booleanValue:
+      output += value.asBool() ? "true" : "false";
+      break;
+
+    case Json::arrayValue: {
+      output += '[';
+      Json::ArrayIndex size = value.size();
+      for (Json::ArrayIndex index = 0; index < size; index++) {
+        if (index > 0)
+          output += ',';
+        write_value(value[index]);
+        check_segment();
+      }
+      output += ']';
+      break;
+    }
+
+    case Json::objectValue: {
+      // members are iterated in key order, without copying keys
+      output += '{';
+      bool first = true;
+      for (auto member = value.begin(); member != value.end(); ++member) {
+        if (!first)
+          output += ',';
+        first = false;
+
+        const char* end;
+        const char* name = member.memberName(&end);
+        write_string(name, end - name, output);
+        output += ':';
+        write_value(*member);
+        check_segment();
+      }
+      output += '}';
+      break;
+    }
+  }
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef REST_CPP_JSON_WRITER_H
+#define REST_CPP_JSON_WRITER_H
+
+#include <functional>
+#include <string>
+
+#include "json/json.h"
+
+namespace REST {
+
+/**
+ * JsonWriter serializes Json::Value straight into response
+ * buffer, without building intermediate strings: integers are
+ * formatted two digits at a time and strings are searched for
+ * characters to escape with Scanner. Output is the same as
+ * Json::FastWriter's one, except for doubles - they are printed
+ * with the shortest precision (15 to 17 digits) which reads back
+ * to the same value, FastWriter always uses 17 digits.
+ *
+ * When `segment` is given, `flush` is called whenever output
+ * grows past SEGMENT_SIZE bytes, so large documents may be sent
+ * while they are still being written.
+ *
+ * @private
+ * @see Response
+ */
+class JsonWriter final {
+
+  public:
+    typedef std::function<void(std::string&)> Flush;
+
+    static size_t SEGMENT_SIZE;
+
+    //! appends `value` and new line to `output`
+    static void write(Json::Value const& value, std::string& output, Flush const& flush = Flush());
+
+    static void write_integer(Json::LargestInt value, std::string& output);
+    static void write_integer(Json::LargestUInt value, std::string& output);
+    static void write_double(double value, std::string& output);
+    static void write_string(const char* data, size_t size, std::string& output);
+
+  private:
+    JsonWriter(std::string& output, Flush const& flush) : output(output), flush(flush) {}
+
+    void write_value(Json::Value const& value);
+    void check_segment();
+
+    std::string& output;
+    Flush const& flush;
+};
+
+}
+
+#endif
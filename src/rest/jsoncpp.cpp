@@ -2270,30 +2270,13 @@ void ValueIteratorBase::decrement() {
 
 ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance(const SelfType& other) const {
-#ifdef JSON_USE_CPPTL_SMALLMAP
-  return other.current_ - current_;
-#else
   // Iterator for null value are initialized using the default
-  // constructor, which initialize current_ to the default
-  // std::map::iterator. As begin() and end() are two instance
-  // of the default std::map::iterator, they can not be compared.
-  // To allow this, we handle this comparison specifically.
+  // constructor, both of them are null.
   if (isNull_ && other.isNull_) {
     return 0;
   }
 
-  // Usage of std::distance is not portable (does not compile with Sun Studio 12
-  // RogueWave STL,
-  // which is the one used by default).
-  // Using a portable hand-made version for non random iterator instead:
-  //   return difference_type( std::distance( current_, other.current_ ) );
-  difference_type myDistance = 0;
-  for (Value::ObjectValues::iterator it = current_; it != other.current_;
-       ++it) {
-    ++myDistance;
-  }
-  return myDistance;
-#endif
+  return difference_type(other.current_ - current_);
 }
 
 bool ValueIteratorBase::isEqual(const SelfType& other) const {
@@ -2432,6 +2415,9 @@ ValueIterator& ValueIterator::operator=(const SelfType& other) {
 #endif
 #include <cstddef> // size_t
 #include <algorithm> // min()
+// strings and members of values parsed from requests live in worker's arena
+#include "arena.h"
+#include <new>
 
 #define JSON_ASSERT_UNREACHABLE assert(false)
 
@@ -2500,7 +2486,7 @@ static inline char* duplicateStringValue(const char* value,
   if (length >= (size_t)Value::maxInt)
     length = Value::maxInt - 1;
 
-  char* newString = static_cast<char*>(malloc(length + 1));
+  char* newString = static_cast<char*>(REST::Arena::allocate_current(length + 1));
   if (newString == NULL) {
     throwRuntimeError(
         "in Json::Value::duplicateStringValue(): "
@@ -2523,7 +2509,7 @@ static inline char* duplicateAndPrefixStringValue(
                       "in Json::Value::duplicateAndPrefixStringValue(): "
                       "length too big for prefixing");
   unsigned actualLength = length + static_cast<unsigned>(sizeof(unsigned)) + 1U;
-  char* newString = static_cast<char*>(malloc(actualLength));
+  char* newString = static_cast<char*>(REST::Arena::allocate_current(actualLength));
   if (newString == 0) {
     throwRuntimeError(
         "in Json::Value::duplicateAndPrefixStringValue(): "
@@ -2548,7 +2534,7 @@ inline static void decodePrefixedString(
 }
 /** Free the string duplicated by duplicateStringValue()/duplicateAndPrefixStringValue().
  */
-static inline void releaseStringValue(char* value) { free(value); }
+static inline void releaseStringValue(char* value) { REST::Arena::release(value); }
 
 } // namespace Json
 
@@ -2638,15 +2624,39 @@ Value::CZString::CZString(char const* str, unsigned ulength, DuplicationPolicy a
   storage_.length_ = ulength & 0x3FFFFFFF;
 }
 
+// Keys most of documents use are not duplicated, members refer to
+// these instead, as if they were static strings.
+static const char* const internedKeys[] = {
+  "id", "key", "url", "code", "data", "name", "path", "size", "tags", "text",
+  "time", "type", "user", "count", "email", "error", "items", "state",
+  "title", "value", "result", "status", "message", "created", "updated",
+  "version", "description"
+};
+
+static char const* internedKey(char const* str, unsigned length) {
+  for (size_t i = 0; i < sizeof(internedKeys) / sizeof(internedKeys[0]); ++i) {
+    char const* key = internedKeys[i];
+    if (key[0] == str[0] && strlen(key) == length && memcmp(key, str, length) == 0)
+      return key;
+  }
+  return 0;
+}
+
 Value::CZString::CZString(const CZString& other)
-    : cstr_(other.storage_.policy_ != noDuplication && other.cstr_ != 0
-                ? duplicateStringValue(other.cstr_, other.storage_.length_)
-                : other.cstr_) {
-  storage_.policy_ = (other.cstr_
-                 ? (static_cast<DuplicationPolicy>(other.storage_.policy_) == noDuplication
-                     ? noDuplication : duplicate)
-                 : static_cast<DuplicationPolicy>(other.storage_.policy_));
+    : cstr_(other.cstr_) {
+  storage_.policy_ = other.storage_.policy_;
   storage_.length_ = other.storage_.length_;
+  if (other.cstr_ == 0 || other.storage_.policy_ == noDuplication)
+    return;
+
+  char const* interned = internedKey(other.cstr_, other.storage_.length_);
+  if (interned) {
+    cstr_ = interned;
+    storage_.policy_ = noDuplication;
+  } else {
+    cstr_ = duplicateStringValue(other.cstr_, other.storage_.length_);
+    storage_.policy_ = duplicate;
+  }
 }
 
 #if JSON_HAS_RVALUE_REFERENCES
@@ -2702,6 +2712,162 @@ const char* Value::CZString::data() const { return cstr_; }
 unsigned Value::CZString::length() const { return storage_.length_; }
 bool Value::CZString::isStaticString() const { return storage_.policy_ == noDuplication; }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+Value::ObjectValues::ObjectValues() : items_(0), size_(0), capacity_(0) {}
+
+Value::ObjectValues::ObjectValues(ObjectValues const& other)
+    : items_(0), size_(0), capacity_(0) {
+  if (other.size_ == 0)
+    return;
+
+  items_ = static_cast<value_type**>(
+      REST::Arena::allocate_current(other.size_ * sizeof(value_type*)));
+  capacity_ = other.size_;
+  for (; size_ < other.size_; ++size_) {
+    void* memory = REST::Arena::allocate_current(sizeof(value_type));
+    try {
+      items_[size_] = new (memory) value_type(*other.items_[size_]);
+    } catch (...) {
+      REST::Arena::release(memory);
+      clear();
+      REST::Arena::release(items_);
+      throw;
+    }
+  }
+}
+
+Value::ObjectValues::~ObjectValues() {
+  clear();
+  if (items_)
+    REST::Arena::release(items_);
+}
+
+void* Value::ObjectValues::operator new(size_t size) {
+  return REST::Arena::allocate_current(size);
+}
+
+void Value::ObjectValues::operator delete(void* pointer) {
+  REST::Arena::release(pointer);
+}
+
+void Value::ObjectValues::clear() {
+  for (size_t i = 0; i < size_; ++i) {
+    items_[i]->~value_type();
+    REST::Arena::release(items_[i]);
+  }
+  size_ = 0;
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::find(CZString const& key) const {
+  iterator it = lower_bound(key);
+  if (it != end() && (*it).first == key)
+    return it;
+  return end();
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::lower_bound(CZString const& key) const {
+  if (size_ == 0 || items_[size_ - 1]->first < key)
+    return end();
+
+  value_type** first = items_;
+  size_t count = size_ - 1;
+  while (count > 0) {
+    size_t half = count / 2;
+    if (first[half]->first < key) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return iterator(first);
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::insert(iterator position, value_type const& value) {
+  size_t index = static_cast<size_t>(position.item_ - items_);
+
+  if (size_ == capacity_) {
+    size_t capacity = capacity_ ? capacity_ * 2 : 4;
+    value_type** items = static_cast<value_type**>(
+        REST::Arena::allocate_current(capacity * sizeof(value_type*)));
+    if (size_)
+      memcpy(items, items_, size_ * sizeof(value_type*));
+    if (items_)
+      REST::Arena::release(items_);
+    items_ = items;
+    capacity_ = capacity;
+  }
+
+  void* memory = REST::Arena::allocate_current(sizeof(value_type));
+  value_type* member;
+  try {
+    member = new (memory) value_type(value);
+  } catch (...) {
+    REST::Arena::release(memory);
+    throw;
+  }
+
+  memmove(items_ + index + 1, items_ + index, (size_ - index) * sizeof(value_type*));
+  items_[index] = member;
+  ++size_;
+  return iterator(items_ + index);
+}
+
+void Value::ObjectValues::erase(iterator position) {
+  size_t index = static_cast<size_t>(position.item_ - items_);
+  items_[index]->~value_type();
+  REST::Arena::release(items_[index]);
+  memmove(items_ + index, items_ + index + 1, (size_ - index - 1) * sizeof(value_type*));
+  --size_;
+}
+
+void Value::ObjectValues::erase(CZString const& key) {
+  iterator it = find(key);
+  if (it != end())
+    erase(it);
+}
+
+Value& Value::ObjectValues::operator[](CZString const& key) {
+  iterator it = lower_bound(key);
+  if (it == end() || !((*it).first == key))
+    it = insert(it, value_type(key, nullRef));
+  return (*it).second;
+}
+
+bool Value::ObjectValues::operator==(ObjectValues const& other) const {
+  if (size_ != other.size_)
+    return false;
+  for (size_t i = 0; i < size_; ++i) {
+    if (!(items_[i]->first == other.items_[i]->first) ||
+        items_[i]->second != other.items_[i]->second)
+      return false;
+  }
+  return true;
+}
+
+bool Value::ObjectValues::operator<(ObjectValues const& other) const {
+  // as std::map compares, lexicographically by members
+  for (size_t i = 0; i < size_ && i < other.size_; ++i) {
+    value_type const& member = *items_[i];
+    value_type const& otherMember = *other.items_[i];
+    if (member.first < otherMember.first) return true;
+    if (otherMember.first < member.first) return false;
+    if (member.second < otherMember.second) return true;
+    if (otherMember.second < member.second) return false;
+  }
+  return size_ < other.size_;
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -0,0 +1,105 @@
+#ifndef REST_CPP_LOAD_H
+#define REST_CPP_LOAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace REST {
+
+/**
+ * Load is number of clients of single Worker and its recent
+ * service time. It is updated by Dispatcher and Workers and read
+ * without any lock. Every Load takes whole cache line, so Workers
+ * updating their own ones do not invalidate each other's. Loads
+ * must be allocated with Load::Allocator, plain `new` does not
+ * respect alignment wider than max_align_t in C++11.
+ *
+ * @private
+ * @see Dispatcher
+ */
+class alignas(64) Load final {
+
+  public:
+    /**
+     * Standard allocator, which aligns memory to alignment of T.
+     */
+    template <class T>
+    class Allocator {
+      public:
+        typedef T value_type;
+
+        Allocator() {}
+        template <class U>
+        Allocator(Allocator<U> const&) {}
+
+        T* allocate(size_t n) {
+          void* memory = nullptr;
+          if (posix_memalign(&memory, alignof(T) < sizeof(void*) ? sizeof(void*) : alignof(T), n * sizeof(T)) != 0)
+            throw std::bad_alloc();
+          return static_cast<T*>(memory);
+        }
+
+        void deallocate(T* pointer, size_t) {
+          free(pointer);
+        }
+
+        template <class U>
+        bool operator==(Allocator<U> const&) const { return true; }
+        template <class U>
+        bool operator!=(Allocator<U> const&) const { return false; }
+    };
+
+    Load() : count(0), service_time(0) {}
+
+    void increment() {
+      count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void decrement() {
+      size_t current = count.load(std::memory_order_relaxed);
+      while (current > 0 && !count.compare_exchange_weak(current, current - 1, std::memory_order_relaxed));
+    }
+
+    size_t get() const {
+      return count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds request service time to exponentially weighted moving
+     * average (new sample weights 1/8). Average is kept in 1/256
+     * of microsecond, so short samples still move it and it decays
+     * towards them. Only owning Worker records.
+     */
+    void record(uint64_t microseconds) {
+      uint64_t sample = microseconds << LATENCY_SHIFT;
+      uint64_t average = service_time.load(std::memory_order_relaxed);
+
+      if (average == 0)
+        average = sample;
+      else
+        average = average - average / 8 + sample / 8;
+
+      // zero is kept for worker which served nothing yet
+      service_time.store(average > 0 ? average : 1, std::memory_order_relaxed);
+    }
+
+    //! average service time in microseconds, 0 if nothing was served yet
+    double latency() const {
+      return service_time.load(std::memory_order_relaxed) / double(1 << LATENCY_SHIFT);
+    }
+
+  private:
+    const static int LATENCY_SHIFT = 8;
+
+    std::atomic<size_t> count;
+    std::atomic<uint64_t> service_time;
+};
+
+static_assert(sizeof(Load) == 64, "Load must take exactly one cache line");
+
+}
+
+#endif
@@ -0,0 +1,277 @@
+#include "message_pack.h"
+#include "body_format.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace REST {
+
+static void write_unsigned(uint64_t value, std::string& output) {
+  if (value < 0x80)
+    output += static_cast<char>(value);
+  else if (value <= UINT8_MAX)
+    BodyFormat::put(output, 0xcc, value, 1);
+  else if (value <= UINT16_MAX)
+    BodyFormat::put(output, 0xcd, value, 2);
+  else if (value <= UINT32_MAX)
+    BodyFormat::put(output, 0xce, value, 4);
+  else
+    BodyFormat::put(output, 0xcf, value, 8);
+}
+
+static void write_signed(int64_t value, std::string& output) {
+  if (value >= 0)
+    write_unsigned(static_cast<uint64_t>(value), output);
+  else if (value >= -32)
+    output += static_cast<char>(value);
+  else if (value >= INT8_MIN)
+    BodyFormat::put(output, 0xd0, static_cast<uint64_t>(value), 1);
+  else if (value >= INT16_MIN)
+    BodyFormat::put(output, 0xd1, static_cast<uint64_t>(value), 2);
+  else if (value >= INT32_MIN)
+    BodyFormat::put(output, 0xd2, static_cast<uint64_t>(value), 4);
+  else
+    BodyFormat::put(output, 0xd3, static_cast<uint64_t>(value), 8);
+}
+
+static void write_double(double value, std::string& output) {
+  float single = static_cast<float>(value);
+
+  if (std::fabs(value) <= FLT_MAX && static_cast<double>(single) == value) {
+    uint32_t bits;
+    memcpy(&bits, &single, sizeof(bits));
+    BodyFormat::put(output, 0xca, bits, 4);
+  } else {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    BodyFormat::put(output, 0xcb, bits, 8);
+  }
+}
+
+static void write_string(const char* data, size_t size, std::string& output) {
+  if (size < 32)
+    output += static_cast<char>(0xa0 | size);
+  else if (size <= UINT8_MAX)
+    BodyFormat::put(output, 0xd9, size, 1);
+  else if (size <= UINT16_MAX)
+    BodyFormat::put(output, 0xda, size, 2);
+  else
+    BodyFormat::put(output, 0xdb, size, 4);
+
+  output.append(data, size);
+}
+
+//! header of array or map, `fix` is type of its shortest form
+static void write_container(uint8_t fix, uint8_t type16, size_t size, std::string& output) {
+  if (size < 16)
+    output += static_cast<char>(fix | size);
+  else if (size <= UINT16_MAX)
+    BodyFormat::put(output, type16, size, 2);
+  else
+    BodyFormat::put(output, type16 + 1, size, 4);
+}
+
+void MessagePack::write(Json::Value const& value, std::string& output) {
+  switch (value.type()) {
+    case Json::nullValue:
+      output += static_cast<char>(0xc0);
+      break;
+
+    case Json::booleanValue:
+      output += static_cast<char>(value.asBool() ? 0xc3 : 0xc2);
+      break;
+
+    case Json::intValue:
+      write_signed(value.asLargestInt(), output);
+      break;
+
+    case Json::uintValue:
+      write_unsigned(value.asLargestUInt(), output);
+      break;
+
+    case Json::realValue:
+      write_double(value.asDouble(), output);
+      break;
+
+    case Json::stringValue: {
+      const char* begin;
+      const char* end;
+      if (value.getString(&begin, &end))
+        write_string(begin, end - begin, output);
+      else
+        write_string("", 0, output);
+      break;
+    }
+
+    case Json::arrayValue: {
+      Json::ArrayIndex size = value.size();
+      write_container(0x90, 0xdc, size, output);
+      for (Json::ArrayIndex index = 0; index < size; index++)
+        write(value[index], output);
+      break;
+    }
+
+    case Json::objectValue: {
+      write_container(0x80, 0xde, value.size(), output);
+      for (auto member = value.begin(); member != value.end(); ++member) {
+        const char* end;
+        const char* name = member.memberName(&end);
+        write_string(name, end - name, output);
+        write(*member, output);
+      }
+      break;
+    }
+  }
+}
+
+//! length of string which starts with `type`, false if it is not string
+static bool string_length(const unsigned char*& p, const unsigned char* end, uint8_t type, uint64_t& length) {
+  if ((type & 0xe0) == 0xa0) {
+    length = type & 0x1f;
+    return true;
+  }
+
+  switch (type) {
+    case 0xd9: case 0xc4: return BodyFormat::take(p, end, 1, length);
+    case 0xda: case 0xc5: return BodyFormat::take(p, end, 2, length);
+    case 0xdb: case 0xc6: return BodyFormat::take(p, end, 4, length);
+    default: return false;
+  }
+}
+
+static bool read_value(const unsigned char*& p, const unsigned char* end, Json::Value& value, size_t depth) {
+  if (p == end || depth > BodyFormat::MAX_DEPTH)
+    return false;
+
+  uint8_t type = *p++;
+  uint64_t number;
+  uint64_t count;
+
+  // positive and negative fixint
+  if (type < 0x80) {
+    value = BodyFormat::integer(type, false);
+    return true;
+  }
+  if (type >= 0xe0) {
+    value = BodyFormat::integer(0x100 - type, true);
+    return true;
+  }
+
+  switch (type) {
+    case 0xc0:
+      value = Json::Value();
+      return true;
+
+    case 0xc2:
+    case 0xc3:
+      value = type == 0xc3;
+      return true;
+
+    case 0xca: {
+      if (!BodyFormat::take(p, end, 4, number))
+        return false;
+      uint32_t bits = static_cast<uint32_t>(number);
+      float single;
+      memcpy(&single, &bits, sizeof(single));
+      value = static_cast<double>(single);
+      return true;
+    }
+
+    case 0xcb: {
+      if (!BodyFormat::take(p, end, 8, number))
+        return false;
+      double real;
+      memcpy(&real, &number, sizeof(real));
+      value = real;
+      return true;
+    }
+
+    case 0xcc: case 0xcd: case 0xce: case 0xcf:
+      if (!BodyFormat::take(p, end, 1 << (type - 0xcc), number))
+        return false;
+      value = BodyFormat::integer(number, false);
+      return true;
+
+    case 0xd0: case 0xd1: case 0xd2: case 0xd3: {
+      int bytes = 1 << (type - 0xd0);
+      if (!BodyFormat::take(p, end, bytes, number))
+        return false;
+      // sign extended
+      int shift = 64 - 8 * bytes;
+      int64_t signed_number = static_cast<int64_t>(number << shift) >> shift;
+      value = signed_number < 0
+        ? BodyFormat::integer(0 - static_cast<uint64_t>(signed_number), true)
+        : BodyFormat::integer(static_cast<uint64_t>(signed_number), false);
+      return true;
+    }
+
+    case 0xdc: case 0xdd:
+      if (!BodyFormat::take(p, end, type == 0xdc ? 2 : 4, count))
+        return false;
+      break;
+
+    case 0xde: case 0xdf:
+      if (!BodyFormat::take(p, end, type == 0xde ? 2 : 4, count))
+        return false;
+      break;
+
+    default:
+      if ((type & 0xf0) == 0x80 || (type & 0xf0) == 0x90) {
+        count = type & 0x0f;
+        break;
+      }
+
+      if (!string_length(p, end, type, number) || number > static_cast<uint64_t>(end - p))
+        return false;
+      value = Json::Value(reinterpret_cast<const char*>(p), reinterpret_cast<const char*>(p + number));
+      p += number;
+      return true;
+  }
+
+  // arrays and maps, every item takes at least one byte
+  if ((type & 0xf0) == 0x90 || type == 0xdc || type == 0xdd) {
+    if (count > static_cast<uint64_t>(end - p))
+      return false;
+
+    value = Json::Value(Json::arrayValue);
+    for (Json::ArrayIndex index = 0; index < count; index++)
+      if (!read_value(p, end, value[index], depth + 1))
+        return false;
+    return true;
+  }
+
+  if (count > static_cast<uint64_t>(end - p) / 2)
+    return false;
+
+  BodyFormat::Members members;
+  members.reserve(count);
+
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t length;
+    if (p == end)
+      return false;
+    uint8_t key_type = *p++;
+    if (key_type >= 0xc4 && key_type <= 0xc6)
+      return false;
+    if (!string_length(p, end, key_type, length) || length > static_cast<uint64_t>(end - p))
+      return false;
+
+    members.emplace_back(std::string(reinterpret_cast<const char*>(p), length), Json::Value());
+    p += length;
+    if (!read_value(p, end, members.back().second, depth + 1))
+      return false;
+  }
+
+  BodyFormat::assign(value, members);
+  return true;
+}
+
+bool MessagePack::read(const char* data, size_t size, Json::Value& value) {
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+  return read_value(p, end, value, 0) && p == end;
+}
+
+}
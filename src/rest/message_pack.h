@@ -0,0 +1,33 @@
+#ifndef REST_CPP_MESSAGE_PACK_H
+#define REST_CPP_MESSAGE_PACK_H
+
+#include <string>
+
+#include "json/json.h"
+
+namespace REST {
+
+/**
+ * MessagePack encodes Json::Value as MessagePack and decodes it
+ * back. Integers and strings take the shortest form which fits
+ * them, doubles are written as single precision floats when that
+ * keeps their value.
+ *
+ * Binary strings are decoded as strings, extension types are not
+ * supported. Map keys have to be strings.
+ *
+ * @private
+ * @see BodyFormat
+ */
+class MessagePack final {
+
+  public:
+    //! appends `value` to `output`
+    static void write(Json::Value const& value, std::string& output);
+    //! decodes single value taking whole `size` bytes, false if it is not valid
+    static bool read(const char* data, size_t size, Json::Value& value);
+};
+
+}
+
+#endif
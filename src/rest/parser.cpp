@@ -0,0 +1,163 @@
+#include "parser.h"
+#include "scanner.h"
+
+#include <strings.h>
+
+namespace REST {
+
+static const Scanner::Set TARGET_END(" ?");
+
+size_t Parser::MAX_BODY_SIZE = 8 * 1024 * 1024;
+
+void Parser::reset() {
+  state = State::REQUEST_LINE;
+  position = 0;
+  scanned = 0;
+  content_length = 0;
+  has_content_length = too_large = false;
+  headers_count = 0;
+  length = 0;
+  method = path = query = version = body = Slice { 0, 0 };
+}
+
+Parser::Status Parser::parse(const char* buffer, size_t size) {
+  while (state == State::REQUEST_LINE || state == State::HEADERS) {
+    // bytes before `scanned` were searched already
+    const char* nl = Scanner::find(buffer + (scanned > position ? scanned : position), buffer + size, '\n');
+
+    if (nl == buffer + size) {
+      scanned = size;
+
+      // do not let client to send endless headers
+      if (size > MAX_HEADER_SIZE)
+        return Status::ERROR;
+      return Status::INCOMPLETE;
+    }
+
+    size_t start = position;
+    size_t end = nl - buffer;
+    position = end + 1;
+
+    // nor endless lines of them
+    if (position > MAX_HEADER_SIZE)
+      return Status::ERROR;
+
+    if (end > start && buffer[end - 1] == '\r')
+      end--;
+
+    if (state == State::REQUEST_LINE) {
+      // empty lines before request should be ignored
+      if (end == start)
+        continue;
+
+      if (!parse_request_line(buffer, start, end))
+        return Status::ERROR;
+
+      state = State::HEADERS;
+    } else
+    if (end == start) {
+      // empty line, content should follow
+      body = Slice { position, content_length };
+      state = State::BODY;
+    } else
+    if (!parse_header(buffer, start, end)) {
+      return too_large ? Status::TOO_LARGE : Status::ERROR;
+    }
+  }
+
+  if (state == State::BODY) {
+    if (size - position < content_length)
+      return Status::INCOMPLETE;
+
+    length = position + content_length;
+    state = State::DONE;
+  }
+
+  return Status::COMPLETE;
+}
+
+bool Parser::parse_request_line(const char* line, size_t start, size_t end) {
+  const char* last = line + end;
+  const char* first = Scanner::find(line + start, last, ' ');
+  if (first == last)
+    return false;
+
+  size_t target = first - line + 1;
+
+  // path ends with query string or version
+  const char* delimiter = Scanner::find(line + target, last, TARGET_END);
+  const char* second = delimiter;
+  if (delimiter != last && *delimiter == '?')
+    second = Scanner::find(delimiter + 1, last, ' ');
+
+  size_t target_end = second - line;
+
+  method = Slice { start, target - 1 - start };
+  version = second != last ? Slice { target_end + 1, end - target_end - 1 } : Slice { end, 0 };
+
+  if (delimiter != last && *delimiter == '?') {
+    size_t query_start = delimiter - line;
+    path = Slice { target, query_start - target };
+    query = Slice { query_start + 1, target_end - query_start - 1 };
+  } else {
+    path = Slice { target, target_end - target };
+    query = Slice { target_end, 0 };
+  }
+
+  return method.length > 0;
+}
+
+bool Parser::parse_header(const char* line, size_t start, size_t end) {
+  if (headers_count == MAX_HEADERS)
+    return false;
+
+  const char* colon = Scanner::find(line + start, line + end, ':');
+  if (colon == line + end)
+    return false;
+
+  size_t name_end = colon - line;
+  size_t value_start = name_end + 1;
+
+  // strip optional whitespace around value
+  while (value_start < end && (line[value_start] == ' ' || line[value_start] == '\t'))
+    value_start++;
+  while (end > value_start && (line[end - 1] == ' ' || line[end - 1] == '\t'))
+    end--;
+
+  Header& header = headers[headers_count++];
+  header.name = Slice { start, name_end - start };
+  header.value = Slice { value_start, end - value_start };
+
+  if (header.name.length == 14 && strncasecmp(line + start, "Content-Length", 14) == 0) {
+    // digits only, repeated header has to agree with first one
+    size_t length = 0;
+    if (value_start == end)
+      return false;
+
+    for (size_t i = value_start; i < end; i++) {
+      if (line[i] < '0' || line[i] > '9')
+        return false;
+
+      // length * 10 + digit > MAX_BODY_SIZE, without wrapping around
+      size_t digit = line[i] - '0';
+      if (digit > MAX_BODY_SIZE || length > MAX_BODY_SIZE / 10 || length * 10 > MAX_BODY_SIZE - digit) {
+        too_large = true;
+        return false;
+      }
+      length = length * 10 + digit;
+    }
+
+    if (has_content_length && length != content_length)
+      return false;
+    content_length = length;
+    has_content_length = true;
+  }
+
+  // chunked request bodies are not supported
+  if (header.name.length == 17 && strncasecmp(line + start, "Transfer-Encoding", 17) == 0)
+    return false;
+
+  return true;
+}
+
+}
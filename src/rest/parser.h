@@ -0,0 +1,71 @@
+#ifndef REST_CPP_PARSER_H
+#define REST_CPP_PARSER_H
+
+#include <cstddef>
+
+namespace REST {
+
+/**
+ * Parser is resumable HTTP/1.x request parser. It is fed with
+ * whole buffered request so far and continues where it stopped
+ * last time, so request split into many TCP segments is parsed
+ * once. Parser does not copy nor allocate - every part of request
+ * is kept as offset from the beginning of request in buffer,
+ * so buffer may be moved between calls.
+ *
+ * @private
+ * @see Connection
+ */
+class Parser final {
+
+  public:
+    //! TOO_LARGE when body is longer than MAX_BODY_SIZE
+    enum class Status { INCOMPLETE, COMPLETE, ERROR, TOO_LARGE };
+
+    struct Slice {
+      size_t offset;
+      size_t length;
+    };
+
+    struct Header {
+      Slice name;
+      Slice value;
+    };
+
+    const static size_t MAX_HEADERS = 64;
+    const static size_t MAX_HEADER_SIZE = 65536;
+    //! longest body accepted, whole body is buffered before request is handled
+    static size_t MAX_BODY_SIZE;
+
+    Status parse(const char* buffer, size_t length);
+    void reset();
+
+    Slice method;
+    Slice path;
+    Slice query;
+    Slice version;
+    Slice body;
+
+    Header headers[MAX_HEADERS];
+    size_t headers_count = 0;
+
+    //! length of whole request, including its body
+    size_t length = 0;
+
+  private:
+    enum class State { REQUEST_LINE, HEADERS, BODY, DONE };
+
+    bool parse_request_line(const char* line, size_t start, size_t end);
+    bool parse_header(const char* line, size_t start, size_t end);
+
+    State state = State::REQUEST_LINE;
+    size_t position = 0;
+    size_t scanned = 0;
+    size_t content_length = 0;
+    bool has_content_length = false;
+    bool too_large = false;
+};
+
+}
+
+#endif
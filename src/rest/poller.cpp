@@ -0,0 +1,135 @@
+#include "poller.h"
+#include "exceptions.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace REST {
+
+const int Poller::MAX_EVENTS = 256;
+
+Poller::Poller() : events(MAX_EVENTS), native_events(MAX_EVENTS) {
+#ifdef __linux__
+  handle = epoll_create1(EPOLL_CLOEXEC);
+  if (handle == -1)
+    throw ServerError();
+
+  wakeup[0] = wakeup[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup[0] == -1)
+    throw ServerError();
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLET;
+  ev.data.ptr = nullptr;
+  epoll_ctl(handle, EPOLL_CTL_ADD, wakeup[0], &ev);
+#else
+  handle = kqueue();
+  if (handle == -1)
+    throw ServerError();
+
+  if (pipe(wakeup) == -1)
+    throw ServerError();
+  set_blocking(wakeup[0], false);
+  set_blocking(wakeup[1], false);
+
+  struct kevent ev;
+  EV_SET(&ev, wakeup[0], EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+  kevent(handle, &ev, 1, nullptr, 0, nullptr);
+#endif
+}
+
+Poller::~Poller() {
+  close(wakeup[0]);
+  if (wakeup[1] != wakeup[0])
+    close(wakeup[1]);
+  close(handle);
+}
+
+void Poller::add(int fd, void* tag) {
+#ifdef __linux__
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.ptr = tag;
+  if (epoll_ctl(handle, EPOLL_CTL_ADD, fd, &ev) == -1)
+    throw ServerError();
+#else
+  struct kevent ev[2];
+  EV_SET(&ev[0], fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, tag);
+  EV_SET(&ev[1], fd, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, tag);
+  if (kevent(handle, ev, 2, nullptr, 0, nullptr) == -1)
+    throw ServerError();
+#endif
+}
+
+void Poller::remove(int fd) {
+#ifdef __linux__
+  struct epoll_event ev;
+  epoll_ctl(handle, EPOLL_CTL_DEL, fd, &ev);
+#else
+  struct kevent ev[2];
+  EV_SET(&ev[0], fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+  EV_SET(&ev[1], fd, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+  kevent(handle, ev, 2, nullptr, 0, nullptr);
+#endif
+}
+
+int Poller::wait(int timeout) {
+#ifdef __linux__
+  int count = epoll_wait(handle, native_events.data(), MAX_EVENTS, timeout);
+
+  for (int i = 0; i < count; i++) {
+    uint32_t e = native_events[i].events;
+    events[i].tag = native_events[i].data.ptr;
+    events[i].events = ((e & EPOLLIN) ? READ : 0) | ((e & EPOLLOUT) ? WRITE : 0) |
+      ((e & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) ? CLOSED : 0);
+  }
+#else
+  struct timespec ts;
+  ts.tv_sec = timeout / 1000;
+  ts.tv_nsec = (timeout % 1000) * 1000000;
+
+  int count = kevent(handle, nullptr, 0, native_events.data(), MAX_EVENTS, timeout < 0 ? nullptr : &ts);
+
+  for (int i = 0; i < count; i++) {
+    events[i].tag = native_events[i].udata;
+    events[i].events = (native_events[i].filter == EVFILT_READ ? READ : WRITE) |
+      ((native_events[i].flags & (EV_EOF | EV_ERROR)) ? CLOSED : 0);
+  }
+#endif
+
+  if (count == -1 && errno != EINTR)
+    throw ServerError();
+
+  return count < 0 ? 0 : count;
+}
+
+void Poller::wake() {
+#ifdef __linux__
+  uint64_t one = 1;
+  ssize_t r = write(wakeup[1], &one, sizeof(one));
+#else
+  char one = 1;
+  ssize_t r = write(wakeup[1], &one, sizeof(one));
+#endif
+  (void)r;
+}
+
+void Poller::drain() {
+  char buffer[64];
+  while (read(wakeup[0], buffer, sizeof(buffer)) > 0);
+}
+
+void Poller::set_blocking(int fd, bool blocking) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags == -1)
+    return;
+  fcntl(fd, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef REST_CPP_POLLER_H
+#define REST_CPP_POLLER_H
+
+#include <vector>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace REST {
+
+/**
+ * Poller is thin, edge-triggered wrapper over epoll (Linux)
+ * or kqueue (BSD, OS X). Every registered descriptor carries
+ * a tag, which is given back with its events.
+ *
+ * Poller owns wakeup descriptor, which allows other threads
+ * to interrupt wait(). Wakeup events are reported with
+ * nullptr tag.
+ *
+ * @private
+ */
+class Poller final {
+
+  public:
+    enum Events { READ = 1, WRITE = 2, CLOSED = 4 };
+
+    struct Event {
+      void* tag;
+      int events;
+    };
+
+    Poller();
+    ~Poller();
+
+    void add(int handle, void* tag);
+    void remove(int handle);
+
+    int wait(int timeout);
+    Event const& event(int i) const { return events[i]; }
+
+    void wake();
+    void drain();
+
+    static void set_blocking(int handle, bool blocking);
+
+  private:
+    const static int MAX_EVENTS;
+
+    int handle;
+    int wakeup[2];
+
+    std::vector<Event> events;
+#ifdef __linux__
+    std::vector<struct epoll_event> native_events;
+#else
+    std::vector<struct kevent> native_events;
+#endif
+};
+
+}
+
+#endif
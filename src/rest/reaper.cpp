@@ -0,0 +1,150 @@
+#include "reaper.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <ctime>
+#include <cstdint>
+
+namespace REST {
+
+int Reaper::TIMEOUT = 5;
+const size_t Reaper::QUEUE_SIZE = 4096;
+
+Reaper* Reaper::instance() {
+  static Reaper reaper;
+  return &reaper;
+}
+
+Reaper::Reaper() : queue(QUEUE_SIZE), wheel(TIMEOUT + 1), should_run(true) {
+  thread = std::thread([this] () {
+    run();
+  });
+}
+
+Reaper::~Reaper() {
+  should_run = false;
+  poller.wake();
+  thread.join();
+
+  for (auto& socket : sockets)
+    close(socket.first);
+}
+
+void Reaper::adopt(int handle) {
+  // nobody would close it, do it now
+  if (!queue.push(handle)) {
+    close(handle);
+    return;
+  }
+
+  poller.wake();
+}
+
+void Reaper::run() {
+  time_t last_tick = time(0);
+
+  while (should_run) {
+    int count = poller.wait(sockets.empty() ? -1 : 1000);
+
+    for (int i = 0; i < count; i++) {
+      Poller::Event const& event = poller.event(i);
+
+      if (event.tag == nullptr)
+        poller.drain();
+      else
+        drain(static_cast<int>(reinterpret_cast<intptr_t>(event.tag)) - 1);
+    }
+
+    receive();
+
+    // after long sleep whole wheel expires at most once
+    time_t now = time(0);
+    if (now - last_tick > (time_t) wheel.size())
+      last_tick = now - wheel.size();
+    for (; last_tick < now; last_tick++)
+      tick();
+  }
+}
+
+void Reaper::receive() {
+  int handle;
+
+  while (queue.pop(handle)) {
+    size_t slot = (current + TIMEOUT) % wheel.size();
+
+    sockets[handle] = slot;
+    wheel[slot].push_back(handle);
+
+    // tag is socket itself, nullptr is taken by wakeup
+    try {
+      poller.add(handle, reinterpret_cast<void*>(static_cast<intptr_t>(handle) + 1));
+    } catch (...) {
+      reap(handle);
+      continue;
+    }
+
+    // client could have closed it before
+    drain(handle);
+  }
+}
+
+void Reaper::drain(int handle) {
+  // closed already, in this round
+  if (sockets.find(handle) == sockets.end())
+    return;
+
+  char buffer[4096];
+
+  while (true) {
+    ssize_t length = recv(handle, buffer, sizeof(buffer), 0);
+
+    if (length > 0)
+      continue;
+
+    if (length == -1 && errno == EINTR)
+      continue;
+
+    if (length == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+
+    // client closed its side (or connection broke)
+    reap(handle);
+    return;
+  }
+}
+
+void Reaper::reap(int handle) {
+  auto socket = sockets.find(handle);
+  if (socket == sockets.end())
+    return;
+
+  auto& slot = wheel[socket->second];
+  for (auto& h : slot) {
+    if (h == handle) {
+      h = slot.back();
+      slot.pop_back();
+      break;
+    }
+  }
+
+  sockets.erase(socket);
+  poller.remove(handle);
+  close(handle);
+}
+
+void Reaper::tick() {
+  current = (current + 1) % wheel.size();
+
+  // everything in this slot waited TIMEOUT seconds
+  std::vector<int> expired;
+  expired.swap(wheel[current]);
+
+  for (auto handle : expired) {
+    sockets.erase(handle);
+    poller.remove(handle);
+    close(handle);
+  }
+}
+
+}
@@ -0,0 +1,64 @@
+#ifndef REST_CPP_REAPER_H
+#define REST_CPP_REAPER_H
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+
+#include "poller.h"
+#include "ring.h"
+
+namespace REST {
+
+/**
+ * Reaper closes sockets gracefully in background. Worker shuts
+ * down its side of connection and hands the socket over, Reaper
+ * reads (and drops) whatever client still sends until client
+ * closes its side too or TIMEOUT passes, so unread data does not
+ * turn close into reset and Worker does not wait for it.
+ *
+ * Reaper has its own thread and poller, timeouts are kept in
+ * wheel with one slot per second.
+ *
+ * @private
+ * @see Connection
+ */
+class Reaper final {
+
+  public:
+    static Reaper* instance();
+
+    //! takes over half closed socket, it is closed by Reaper
+    void adopt(int handle);
+
+    //! seconds to wait for client to close connection
+    static int TIMEOUT;
+
+  private:
+    Reaper();
+    ~Reaper();
+
+    void run();
+    void receive();
+    void drain(int handle);
+    void reap(int handle);
+    void tick();
+
+    const static size_t QUEUE_SIZE;
+
+    Ring<int> queue;
+    Poller poller;
+
+    //! socket -> index of wheel slot it expires in
+    std::unordered_map<int, size_t> sockets;
+    std::vector< std::vector<int> > wheel;
+    size_t current = 0;
+
+    std::atomic<bool> should_run;
+    std::thread thread;
+};
+
+}
+
+#endif
@@ -1,159 +1,201 @@
 #include "request.h"
+#include "connection.h"
+#include "scanner.h"
+#include <cstdlib>
 #include <cstring>
+#include <strings.h>
 
 namespace REST {
 
-const size_t Request::BUFFER_SIZE = 4096;
+static const Scanner::Set PAIR_DELIMITERS("&=");
 
-Request::Request(int client, struct sockaddr_storage client_addr) : handle(client), addr(client_addr) {
-  std::string line;
-  bool is_header = true;
-  char buffer[BUFFER_SIZE];
-
-  // receive data from client
-  recv(client, buffer, BUFFER_SIZE, 0);
-
-  // parse each line
-  std::istringstream request_stream(buffer);
-  while (std::getline(request_stream, line)) {
-    // if method is undefined, assumie its first line
-    if (method == Method::UNDEFINED) {
-      // so parse header
-      parse_header(line);
-      continue;
-    }
+static bool contains_token(StringView const& value, const char* token) {
+  size_t length = strlen(token);
+  for (size_t i = 0; i + length <= value.size(); i++)
+    if (strncasecmp(value.data() + i, token, length) == 0)
+      return true;
+  return false;
+}
 
-    // next lines are headers, strip them
-    line.erase(line.find_last_not_of(" \n\r\t")+1);
+Request::Request(Connection* c, Arena* arena) :
+  parameters(0, Parameters::hasher(), Parameters::key_equal(), Parameters::allocator_type(arena)),
+  bytes(nullptr, Arena::release), connection(c), handle(c->handle), addr(c->address) {
+  // connection buffered and parsed whole request already, its
+  // buffer is reused by next requests, while request may be kept
+  // by streamer or service after it is handled
+  Parser const& parser = connection->parser;
+  bytes.reset(static_cast<char*>(arena->allocate(parser.length)));
+  memcpy(bytes.get(), connection->request_data(), parser.length);
+  const char* buffer = bytes.get();
+
+  parse_method(StringView(buffer + parser.method.offset, parser.method.length));
+  path = StringView(buffer + parser.path.offset, parser.path.length);
+  query = StringView(buffer + parser.query.offset, parser.query.length);
+
+  for (size_t i = 0; i < parser.headers_count; i++)
+    headers.add(StringView(buffer + parser.headers[i].name.offset, parser.headers[i].name.length),
+                StringView(buffer + parser.headers[i].value.offset, parser.headers[i].value.length));
+
+  raw = content = StringView(buffer + parser.body.offset, parser.body.length);
+  length = raw.size();
+
+  if (!query.empty())
+    parse_query_string(query);
 
-    // if line is empty, then content should follow
-    if (line.size() == 0) {
-      is_header = false;
-      break;
-    }
+  // HTTP/1.1 connections are persistent unless client says otherwise,
+  // HTTP/1.0 ones only when client asks for it
+  keep_alive = chunked = StringView(buffer + parser.version.offset, parser.version.length) == "HTTP/1.1";
 
-    // extract name and value from header
-    size_t colon;
-    std::string name = line.substr(0, colon = line.find(":"));
-    std::string value = line.substr(colon+1);
-    value.erase(0, value.find_first_not_of(" \n\r\t"));
+  auto ch = headers.find(Header::CONNECTION);
 
-    headers.insert(std::make_pair(name, value));
+  if (ch != headers.end()) {
+    if (contains_token(ch->second, "close"))
+      keep_alive = false;
+    else if (contains_token(ch->second, "keep-alive"))
+      keep_alive = true;
   }
 
-  // if has content
-  if (!is_header) {
-    // assume proper content length
-    size_t content_length = header("Content-Length", 0);
-
-    if (content_length == 0)
-      content_length = header("Content-length", 0);
-
-    raw.reserve(content_length);
-    content.reserve(content_length);
-    
-    if (content_length > 0) {
-      // read whats left in header
-      length = std::min(content_length, (size_t)(BUFFER_SIZE - request_stream.tellg()));
-      raw = std::string(buffer, BUFFER_SIZE).substr(request_stream.tellg(), length);
-      content = "";
-
-      // receive some more
-      while (length < content_length) {
-        memset(buffer, 0, BUFFER_SIZE);
-        size_t buffer_length = recv(client, buffer, BUFFER_SIZE, 0);
-        raw += std::string(buffer, buffer_length);
-        content += std::string(buffer, buffer_length);
-        length += buffer_length;
-      }
-    }
-    //std::cout << "content o "<<content_length<<" == "<<length<<" == " <<raw.size()<<"\n";
-  }
-
-  // delete [] buffer;
-
   time = std::chrono::high_resolution_clock::now();
 
   // if has some content
   if (!raw.empty()) {
     // try to parse it
-    auto ct = headers.find("Content-Type");
-
-    if (ct == headers.end())
-      ct = headers.find("Content-type");
+    auto ct = headers.find(Header::CONTENT_TYPE);
 
     if (ct != headers.end()) {
-      if (ct->second == "application/x-www-form-urlencoded") {
+      BodyFormat::Type format;
+
+      if (ct->second.starts_with("application/x-www-form-urlencoded")) {
         parse_query_string(raw);
       } else
-      if (ct->second == "application/json" || ct->second == "text/json") {
-        Json::Reader json_reader;
-        // data = std::make_shared<Json::Value>();
-        json_reader.parse(raw, data, false);
+      if (BodyFormat::of(ct->second, format)) {
+        data.reset(raw.data(), raw.size(), arena, format);
       }
     }
   }
+
+  connection->take_request();
 }
 
-void Request::parse_header(std::string line) {
-  if (line.find("GET") == 0) {
+void Request::parse_method(StringView const& name) {
+  if (name == "GET") {
     method = Method::GET;
   } else
-  if (line.find("HEAD") == 0) {
+  if (name == "HEAD") {
     method = Method::HEAD;
   } else
-  if (line.find("POST") == 0) {
+  if (name == "POST") {
     method = Method::POST;
   } else
-  if (line.find("PUT") == 0) {
+  if (name == "PUT") {
     method = Method::PUT;
   } else
-  if (line.find("PATCH") == 0) {
+  if (name == "PATCH") {
     method = Method::PATCH;
   } else
-  if (line.find("DELETE") == 0) {
+  if (name == "DELETE") {
     method = Method::DELETE;
   } else
-  if (line.find("TRACE") == 0) {
+  if (name == "TRACE") {
     method = Method::TRACE;
   } else
-  if (line.find("CONNECT") == 0) {
+  if (name == "CONNECT") {
     method = Method::CONNECT;
   } else
-  if (line.find("OPTIONS") == 0) {
+  if (name == "OPTIONS") {
     method = Method::OPTIONS;
   }
+}
 
-  size_t path_start = line.find_first_of(" ")+1;
-  size_t path_end = line.rfind("HTTP/1.")-1;
-
-  path = line.substr(path_start, path_end - path_start);
+void Request::parse_query_string(StringView const& query) {
+  const char* position = query.begin();
+  const char* end = query.end();
 
-  size_t path_query = path.find("?");
+  while (position < end) {
+    // name ends with '=' or with next pair
+    const char* delimiter = Scanner::find(position, end, PAIR_DELIMITERS);
+    StringView name(position, delimiter - position);
+    StringView value;
 
-  if (path_query != std::string::npos) {
-    std::string query = path.substr(path_query+1, path.size() - path_query);
+    if (delimiter != end && *delimiter == '=') {
+      const char* value_end = Scanner::find(delimiter + 1, end, '&');
+      value = StringView(delimiter + 1, value_end - delimiter - 1);
+      delimiter = value_end;
+    }
 
-    parse_query_string(query);
+    position = delimiter + 1;
 
-    path.erase(path_query, query.size()+1);
+    if (!name.empty() || !value.empty())
+      parameters[Utils::uri_decode(name)] = Utils::uri_decode(value);
   }
 }
 
-void Request::parse_query_string(std::string query) {
-  query.erase(query.find_last_not_of(" \n\r\t")+1);
-  std::istringstream query_stream(query);
-  std::string pair;
-  while (std::getline(query_stream, pair, '&')) {
-    std::string name, value;
-    size_t value_position = pair.find("=");
+void Request::capture(StringView const& name, StringView const& value, bool splat) {
+  if (captures_count < MAX_CAPTURES)
+    captures[captures_count++] = Capture { name, value, splat };
+}
 
-    name = pair.substr(0, value_position);
-    if (value_position != std::string::npos)
-      value = pair.substr(value_position+1, pair.size() - value_position-1);
+bool Request::route_parameter(std::string const& key, std::string& value) const {
+  // captures are stored deepest first, shallower ones win
+  for (size_t i = captures_count; i-- > 0; ) {
+    Capture const& capture = captures[i];
+
+    if (!capture.splat) {
+      if (capture.name == key) {
+        value = Utils::uri_decode(capture.value);
+        return true;
+      }
+      continue;
+    }
+
+    // splat is available as "0" (whole) and "1".."n" (its segments)
+    if (key.empty() || key.find_first_not_of("0123456789") != std::string::npos)
+      continue;
 
-    parameters[Utils::uri_decode(name)] = Utils::uri_decode(value);
+    size_t n = strtoul(key.c_str(), nullptr, 10);
+    const char* dot = static_cast<const char*>(memrchr(path.data(), '.', path.size()));
+    const char* position = capture.value.begin();
+    const char* end = capture.value.end();
+    size_t index = 0;
+
+    value.clear();
+
+    while (position < end) {
+      const char* next = position;
+      while (next < end && *next != '/' && next != dot)
+        next++;
+
+      if (next > position) {
+        StringView segment(position, next - position);
+        index++;
+
+        if (n == 0) {
+          if (index > 1)
+            value += "/";
+          value += Utils::uri_decode(segment);
+        } else
+        if (n == index) {
+          value = Utils::uri_decode(segment);
+          return true;
+        }
+      }
+
+      position = next + 1;
+    }
+
+    if (n == 0)
+      return true;
   }
+
+  return false;
+}
+
+StringView Request::splat() const {
+  for (size_t i = 0; i < captures_count; i++)
+    if (captures[i].splat)
+      return captures[i].value;
+
+  return StringView();
 }
 
 Request::~Request() {
@@ -6,25 +6,39 @@
 #include <unistd.h>
 #include <string>
 #include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstring>
 #include <unordered_map>
 #include <sstream>
 #include "utils.h"
+#include "string_view.h"
+#include "header.h"
+#include "arena.h"
+#include "json_document.h"
+#include "json_fields.h"
 #include "json/json.h"
 
 namespace REST {
 
 class Worker;
 class Response;
+class Connection;
 /**
  * Basic REST request.
  *
  * Request defines request method, parameters
  * and headers.
+ *
+ * Path, headers and content are views into copy of request
+ * bytes kept in worker's arena, so they stay valid as long as
+ * request itself, even when it outlives connection buffer.
  */
 class Request {
   friend class Dispatcher;
   friend class Worker;
   friend class Response;
+  friend class Router;
 
   public:
     typedef struct {
@@ -32,19 +46,71 @@ class Request {
       int handle;
     } client;
     typedef std::shared_ptr<Request> shared;
+    typedef std::unordered_map< std::string, std::string, std::hash<std::string>, std::equal_to<std::string>,
+      Arena::Allocator< std::pair<const std::string, std::string> > > Parameters;
     enum class Method { GET, HEAD, POST, PUT, DELETE, TRACE, CONNECT, OPTIONS, PATCH, UNDEFINED };
 
-
+    /**
+     * Flat list of request headers, in order they were sent.
+     * Names are case-insensitive, headers known to Header are
+     * found without comparing names.
+     */
+    class Headers {
+      public:
+        typedef std::pair< StringView, StringView > value_type;
+        typedef const value_type* const_iterator;
+
+        Headers() { memset(slots, NONE, sizeof(slots)); }
+
+        const_iterator begin() const { return items; }
+        const_iterator end() const { return items + count; }
+        size_t size() const { return count; }
+
+        const_iterator find(Header::Known header) const {
+          return header < Header::COUNT && slots[header] != NONE ? items + slots[header] : end();
+        }
+
+        const_iterator find(StringView const& name) const {
+          Header::Known header = Header::resolve(name);
+          if (header != Header::UNKNOWN)
+            return find(header);
+
+          for (size_t i = 0; i < count; i++)
+            if (Header::equals(items[i].first, name))
+              return items + i;
+          return end();
+        }
+
+      private:
+        friend class Request;
+        const static size_t CAPACITY = 64;
+        const static uint8_t NONE = 0xff;
+
+        void add(StringView const& name, StringView const& value) {
+          Header::Known header = Header::resolve(name);
+
+          // first one of repeated headers wins
+          if (header != Header::UNKNOWN && slots[header] == NONE)
+            slots[header] = count;
+
+          items[count++] = value_type(name, value);
+        }
+
+        value_type items[CAPACITY];
+        size_t count = 0;
+        uint8_t slots[Header::COUNT];
+    };
 
     ~Request();
 
     Method method = Method::UNDEFINED;
-    std::string path;
-    std::unordered_multimap< std::string, std::string > headers;
-    std::unordered_map< std::string, std::string > parameters;
+    StringView path;
+    StringView query;
+    Headers headers;
+    Parameters parameters;
 
-    std::string raw;
-    std::string content;
+    StringView raw;
+    StringView content;
     size_t length = 0;
 
     template <class T>
@@ -58,28 +124,78 @@ class Request {
 
     template <class T>
     const T parameter(std::string const& key, const T& default_value) {
-      if (parameters[key].empty())
+      std::string value;
+      if (route_parameter(key, value))
+        return value.empty() ? default_value : Utils::parse_string<T>(value);
+
+      auto p = parameters.find(key);
+      if (p == parameters.end() || p->second.empty())
         return default_value;
       else
-        return Utils::parse_string<T>(parameters[key]);
+        return Utils::parse_string<T>(p->second);
     }
 
-    Json::Value data;
+    //! rest of path matched by splat, as client sent it (not decoded)
+    StringView splat() const;
 
-  private:
-    Request(int client, struct sockaddr_storage client_addr);
+    /**
+     * JSON (or MessagePack or CBOR) content, parsed on first use.
+     * `data["key"]`, `*data` or `data->` decode whole document into
+     * Json::Value, while `data.root()` reads only values handler
+     * asks for.
+     */
+    JsonDocument data;
 
-    const static size_t BUFFER_SIZE;
+    //! reads JSON content into `object` bound with REST_JSON_FIELDS, false if it does not match
+    template <class T>
+    bool json(T& object) const {
+      return JsonFields::read(data.root(), object);
+    }
 
-    static Request::shared make(Request::client client) {
-      Request::shared instance(new Request(client.handle, client.address));
-      return instance;
+  private:
+    Request(Connection* connection, Arena* arena);
+
+    //! request and everything it parses is allocated in arena
+    static Request::shared make(Connection* connection, Arena* arena) {
+      void* memory = arena->allocate(sizeof(Request));
+      try {
+        return arena->share(new (memory) Request(connection, arena));
+      } catch (...) {
+        Arena::release(memory);
+        throw;
+      }
     }
 
-    void parse_header(std::string line);
-    void parse_query_string(std::string query);
+    /**
+     * Parameter captured from path by Router. Splat is whole
+     * rest of path.
+     */
+    struct Capture {
+      StringView name;
+      StringView value;
+      bool splat;
+    };
+
+    const static size_t MAX_CAPTURES = 16;
+
+    void capture(StringView const& name, StringView const& value, bool splat);
+    bool route_parameter(std::string const& key, std::string& value) const;
+
+    Capture captures[MAX_CAPTURES];
+    size_t captures_count = 0;
+
+    void parse_method(StringView const& name);
+    void parse_query_string(StringView const& query);
     std::chrono::high_resolution_clock::time_point time;
 
+    bool keep_alive = false;
+    //! client understands chunked transfer encoding (HTTP/1.1)
+    bool chunked = false;
+
+    //! request as client sent it, views point into it
+    std::unique_ptr<char, void (*)(void*)> bytes;
+
+    Connection* connection;
     int handle;
     struct sockaddr_storage addr;
 };
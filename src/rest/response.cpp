@@ -1,28 +1,102 @@
 #include "response.h"
+#include "connection.h"
+#include "clock.h"
+#include "streamers.h"
+#include "json_writer.h"
 #include <thread>
 #include <future>
 #include <csignal>
 
-#ifndef MSG_NOSIGNAL
-# define MSG_NOSIGNAL 0
-# ifdef SO_NOSIGPIPE
-#  define CEPH_USE_SO_NOSIGPIPE
-# else
-#  error "Cannot block SIGPIPE!"
-# endif
-#endif
-
 namespace REST {
 
-Response::Response(Request::shared request, std::vector<std::thread>* s) {
-  streamers = s;
+/**
+ * Preformatted status lines of every status used by the library
+ * (see exceptions.h).
+ */
+static const struct {
+  int status;
+  StringView message;
+  StringView line;
+} STATUS_LINES[] = {
+  { 200, "OK", "HTTP/1.1 200 OK\r\n" },
+  { 206, "Partial Content", "HTTP/1.1 206 Partial Content\r\n" },
+  { 304, "Not Modified", "HTTP/1.1 304 Not Modified\r\n" },
+  { 401, "Not Authorized", "HTTP/1.1 401 Not Authorized\r\n" },
+  { 404, "Not Found", "HTTP/1.1 404 Not Found\r\n" },
+  { 405, "Method Not Allowed", "HTTP/1.1 405 Method Not Allowed\r\n" },
+  { 416, "Range Not Satisfiable", "HTTP/1.1 416 Range Not Satisfiable\r\n" },
+  { 500, "Internal Server Error", "HTTP/1.1 500 Internal Server Error\r\n" },
+  { 501, "Not Implemented", "HTTP/1.1 501 Not Implemented\r\n" },
+  { 503, "Service Unavailable", "HTTP/1.1 503 Service Unavailable\r\n" }
+};
+
+Response::Headers::Headers() {
+  items.reserve(INITIAL_CAPACITY);
+  for (auto& slot : slots)
+    slot = -1;
+}
+
+std::string& Response::Headers::operator[](StringView const& name) {
+  Header::Known header = Header::resolve(name);
+  if (header != Header::UNKNOWN)
+    return (*this)[header];
+
+  for (auto& item : items)
+    if (Header::equals(item.first, name))
+      return item.second;
+
+  return add(name, header);
+}
+
+std::string& Response::Headers::operator[](Header::Known header) {
+  if (slots[header] != -1)
+    return items[slots[header]].second;
+
+  return add(Header::name(header), header);
+}
+
+Response::Headers::iterator Response::Headers::find(StringView const& name) {
+  Header::Known header = Header::resolve(name);
+  if (header != Header::UNKNOWN)
+    return find(header);
+
+  for (auto item = items.begin(); item != items.end(); ++item)
+    if (Header::equals(item->first, name))
+      return item;
+
+  return items.end();
+}
+
+Response::Headers::iterator Response::Headers::find(Header::Known header) {
+  return slots[header] != -1 ? items.begin() + slots[header] : items.end();
+}
+
+std::string& Response::Headers::add(StringView const& name, Header::Known header) {
+  if (header != Header::UNKNOWN)
+    slots[header] = items.size();
+
+  items.push_back(value_type(name, std::string()));
+  return items.back().second;
+}
+
+Response::Response(Request::shared request) {
+  connection = request->connection;
   handle = request->handle;
   start_time = request->time;
-  headers["Content-Type"] = "text/plain; charset=utf-8";
-  headers["Connection"] = "close";
+  is_head = request->method == Request::Method::HEAD;
+  chunked = request->chunked;
+
+  auto accept_encoding = request->headers.find(Header::ACCEPT_ENCODING);
+  if (accept_encoding != request->headers.end())
+    accepted = Compressor::negotiate(accept_encoding->second);
+  auto accept = request->headers.find(Header::ACCEPT);
+  if (accept != request->headers.end())
+    format = BodyFormat::negotiate(accept->second);
+  headers[Header::CONTENT_TYPE] = "text/plain; charset=utf-8";
+  headers[Header::CONNECTION] = (request->keep_alive && connection->is_reusable()) ? "keep-alive" : "close";
 }
 
-Response::Response(Request::shared request, HTTP::Error &error) : Response(request, nullptr) {
+Response::Response(Request::shared request, HTTP::Error &error) : Response(request) {
   status = error.code();
   status_message = error.what();
   use_json();
@@ -32,39 +106,146 @@ Response::Response(Request::shared request, HTTP::Error &error) : Response(reque
 }
 
 void Response::use_json() {
-  headers["Content-Type"] = "application/json; charset=utf-8";
+  set_json_type();
   is_json = true;
 }
 
+void Response::set_json_type() {
+  headers[Header::CONTENT_TYPE] = "application/json; charset=utf-8";
+}
+
+void Response::send_file(File::shared const& f, off_t offset, size_t length) {
+  file = f;
+  file_offset = offset;
+  file_length = length;
+}
+
 void Response::stream_async(std::function<void(int)> streamer) {
   stream(streamer, true);
 }
 
-void Response::stream(std::function<void(int)> streamer, bool async) {
+void Response::stream_async(std::function<void(Writer&)> streamer) {
+  stream(streamer, true);
+}
+
+void Response::stream(std::function<void(Writer&)> streamer, bool async) {
+  // nothing was written yet, client may be refused
+  if (async && !Streamers::instance()->reserve())
+    throw HTTP::ServiceUnavailable();
+
+  Writer::shared writer = start_stream(async);
+
+  if (!async) {
+    try {
+      streamer(*writer);
+      writer->end();
+    } catch (...) {
+      writer->abort();
+    }
+    return;
+  }
+
+  connection->stream(writer);
+
+  Streamers::instance()->run([streamer, writer]() {
+    try {
+      streamer(*writer);
+      writer->end();
+    } catch (...) {
+      writer->abort();
+    }
+  });
+}
+
+Writer::shared Response::start_stream(bool async) {
   is_streamed = true;
 
-  std::string content = "HTTP/1.1 " + std::to_string(status) + " " + status_message + "\r\n";
-  headers.insert(std::make_pair("Date", Utils::rfc1123_datetime(time(0))));
+  // HTTP/1.0 body ends with connection
+  if (chunked)
+    headers["Transfer-Encoding"] = "chunked";
+  else
+    headers[Header::CONNECTION] = "close";
+
+  Compressor::Encoding encoding = compressor != nullptr ? this->encoding() : Compressor::IDENTITY;
+  if (encoding != Compressor::IDENTITY)
+    headers[Header::CONTENT_ENCODING] = Compressor::name(encoding).str();
+
+  std::string content = status_line();
+  write_head(content);
+  connection->write(content);
+
+  Writer::shared writer = std::make_shared<Writer>(connection, chunked, headers[Header::CONNECTION] == "keep-alive");
+
+  // streamer thread has its own compressor
+  if (encoding != Compressor::IDENTITY)
+    writer->compress(encoding, async ? nullptr : compressor);
+
+  return writer;
+}
+
+StringView Response::status_line() const {
+  for (auto const& status_line : STATUS_LINES)
+    if (status_line.status == status && status_line.message == status_message)
+      return status_line.line;
+
+  return StringView();
+}
+
+size_t Response::write_head(std::string& content) {
+  // status line, unless it is preformatted one
+  if (status_line().empty()) {
+    content += "HTTP/1.1 ";
+    content += std::to_string(status);
+    content += " ";
+    content += status_message;
+    content += "\r\n";
+  }
+
+  size_t status_length = content.size();
 
   // add headers
-  for (auto header : headers)
-    content += header.first + ": " + header.second + "\r\n";
+  for (auto const& header : headers) {
+    content += header.first;
+    content += ": ";
+    content += header.second;
+    content += "\r\n";
+  }
+
+  if (headers.find(Header::DATE) == headers.end()) {
+    StringView date = Clock::date();
+    content += "Date: ";
+    content.append(date.data(), date.size());
+    content += "\r\n";
+  }
 
   content += "\r\n";
+  return status_length;
+}
+
+void Response::stream(std::function<void(int)> streamer, bool async) {
+  if (async && !Streamers::instance()->reserve())
+    throw HTTP::ServiceUnavailable();
+
+  is_streamed = true;
+
+  // stream ends when connection is closed
+  headers[Header::CONNECTION] = "close";
 
-  // send every byte
-  ::send(handle, content.c_str(), content.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+  std::string content = status_line();
+  write_head(content);
+
+  // streamer takes over the socket, it is no longer polled by worker
+  connection->write(content);
+  connection->detach();
 
   if (async) {
     int h = handle;
-    streamers->emplace_back([streamer, h]() {
-      signal(SIGPIPE, SIG_IGN);
+    Streamers::instance()->run([streamer, h]() {
       try {
-        // std::this_thread::yield();
         streamer(h);
-        close(h);
       } catch (...) {
       }
+      close(h);
     });
   } else {
     std::this_thread::yield();
@@ -73,55 +254,149 @@ void Response::stream(std::function<void(int)> streamer, bool async) {
   }
 }
 
+Compressor::Encoding Response::encoding() {
+  if (Compressor::LEVEL == 0 || status == 206)
+    return Compressor::IDENTITY;
+
+  // encoded already
+  if (headers.find(Header::CONTENT_ENCODING) != headers.end())
+    return Compressor::IDENTITY;
+
+  auto content_type = headers.find(Header::CONTENT_TYPE);
+  if (content_type == headers.end() || !Compressor::is_compressible(content_type->second))
+    return Compressor::IDENTITY;
+
+  // response depends on Accept-Encoding, whatever client sent
+  vary("Accept-Encoding");
+
+  return accepted;
+}
+
+void Response::vary(StringView const& header) {
+  std::string& value = headers["Vary"];
+
+  for (size_t position = 0; position < value.size(); ) {
+    size_t next = value.find(',', position);
+    if (next == std::string::npos)
+      next = value.size();
+
+    size_t begin = value.find_first_not_of(' ', position);
+    size_t end = next;
+    while (end > begin && value[end - 1] == ' ')
+      end--;
+    if (begin < end && Header::equals(StringView(value.data() + begin, end - begin), header))
+      return;
+    position = next + 1;
+  }
+
+  if (!value.empty())
+    value += ", ";
+  value.append(header.data(), header.size());
+}
+
+void Response::compress(std::string& payload) {
+  if (payload.size() < Compressor::MIN_SIZE)
+    return;
+
+  Compressor::Encoding encoding = this->encoding();
+  if (encoding == Compressor::IDENTITY)
+    return;
+
+  std::string compressed;
+  if (!compressor->compress(encoding, payload.data(), payload.size(), compressed))
+    return;
+
+  payload = std::move(compressed);
+  headers[Header::CONTENT_ENCODING] = Compressor::name(encoding).str();
+}
+
 size_t Response::send() {
   if (is_streamed)
     return 0;
 
-  size_t bytes_sent = 0;
-
   std::string payload;
 
+  // structured body depends on Accept
+  if (is_json)
+    vary("Accept");
+
+  if (is_json && format != BodyFormat::JSON) {
+    headers[Header::CONTENT_TYPE] = BodyFormat::content_type(format).str();
+    BodyFormat::write(format, data, payload);
+  } else
   if (is_json) {
-    Json::FastWriter json_writer;
-    payload = json_writer.write(data);
+    Writer::shared writer;
+    JsonWriter::Flush flush;
+
+    // large documents are sent in chunks while they are being
+    // written, instead of being buffered whole - socket takes what
+    // it can, what slow client does not take is left for poller,
+    // Worker must not wait for it
+    if (chunked && !is_head && status != 304 && file == nullptr)
+      flush = [this, &writer](std::string& segment) {
+        if (writer == nullptr) {
+          writer = start_stream(false);
+          writer->waits = false;
+        }
+        writer->write(segment.data(), segment.size());
+        segment.clear();
+        connection->flush();
+      };
+
+    JsonWriter::write(data, payload, flush);
+
+    if (writer != nullptr) {
+      writer->write(payload.data(), payload.size());
+      writer->end();
+      return 0;
+    }
   } else {
-    payload = raw;
+    payload = std::move(raw);
   }
 
-  // start http
-  std::string content = "HTTP/1.1 " + std::to_string(status) + " " + status_message + "\r\n";
+  if (compressor != nullptr && file == nullptr)
+    compress(payload);
 
-  // content size
-  headers["Content-Length"] = std::to_string(payload.size());
-  headers["Server"] += ", took " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time).count() / 1000.0f) + "ms";
-  headers.insert(std::make_pair("Date", Utils::rfc1123_datetime(time(0))));
+  size_t content_length = file ? file_length : payload.size();
 
-  // add headers
-  for (auto header : headers)
-    content += header.first + ": " + header.second + "\r\n";
+  // content size, not modified response has no content
+  if (status != 304)
+    headers[Header::CONTENT_LENGTH] = std::to_string(content_length);
 
-  content += "\r\n";
+  if (is_head)
+    payload.clear();
 
-  content += payload;
+  headers[Header::SERVER] += ", took " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time).count() / 1000.0f) + "ms";
 
-  // send every byte 
-  bytes_sent = ::send(handle, content.c_str(), content.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+  std::string local;
+  std::string& content = head != nullptr ? *head : local;
 
-  // close connection with client
-  shutdown(handle, SHUT_WR);
-  for(;;) {
-    char buffer[4000];
-    int res=read(handle, buffer, 4000);
-    if(res < 0) {
-        perror("reading");
-        exit(1);
-    }
-    if(!res)
-        break;
-  }
+  content.clear();
+  size_t head_offset = write_head(content);
+
+  // status line is either preformatted one or in the buffer
+  StringView line = status_line();
+  if (line.empty())
+    line = StringView(content.data(), head_offset);
+
+  struct iovec parts[2] = {
+    { const_cast<char*>(line.data()), line.size() },
+    { const_cast<char*>(content.data()) + head_offset, content.size() - head_offset }
+  };
+
+  size_t bytes_sent = line.size() + content.size() - head_offset + (is_head ? 0 : content_length);
+  bool keep_alive = headers[Header::CONNECTION] == "keep-alive";
+
+  // status line, headers and payload go out with one writev,
+  // payload is not copied
+  connection->write(parts, 2, std::move(payload));
+
+  if (file && !is_head)
+    connection->write(file, file_offset, file_length);
+
+  if (!keep_alive)
+    connection->finish();
 
-  close(handle);
-  
   return bytes_sent;
 }
 
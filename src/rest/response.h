@@ -3,12 +3,20 @@
 
 #include "exceptions.h"
 #include "request.h"
+#include "header.h"
+#include "file.h"
+#include "compressor.h"
+#include "body_format.h"
+#include "writer.h"
+#include "json_fields.h"
 #include "json/json.h"
 
 #include <chrono>
+#include <functional>
 #include <thread>
 #include <string>
 #include <map>
+#include <vector>
 #include <unistd.h>
 #include <iostream>
 
@@ -27,29 +35,123 @@ class Response {
     ~Response();
 
 
+    /**
+     * Flat list of response headers, in order they were set.
+     * Names are case-insensitive, headers known to Header are
+     * found without comparing names.
+     */
+    class Headers {
+      public:
+        typedef std::pair< std::string, std::string > value_type;
+        typedef std::vector< value_type >::iterator iterator;
+        typedef std::vector< value_type >::const_iterator const_iterator;
+
+        Headers();
+
+        //! value of header, empty one is added if there is none
+        std::string& operator[](StringView const& name);
+        std::string& operator[](Header::Known header);
+
+        iterator find(StringView const& name);
+        iterator find(Header::Known header);
+
+        //! adds headers which are not set yet
+        template <class I>
+        void insert(I first, I last) {
+          for (; first != last; ++first)
+            if (find(first->first) == end())
+              add(first->first, Header::resolve(first->first)) = first->second;
+        }
+
+        iterator begin() { return items.begin(); }
+        iterator end() { return items.end(); }
+        const_iterator begin() const { return items.begin(); }
+        const_iterator end() const { return items.end(); }
+        size_t size() const { return items.size(); }
+
+      private:
+        const static size_t INITIAL_CAPACITY = 8;
+
+        std::string& add(StringView const& name, Header::Known header);
+
+        std::vector< value_type > items;
+        int slots[Header::COUNT];
+    };
+
     int status = 200;
     std::string status_message = "OK";
     std::string raw;
-    std::unordered_map< std::string, std::string > headers;
+    Headers headers;
 
+    //! sends `data` as body, in JSON or in binary format client asks for (see `format`)
     void use_json();
+    //! sends `object` bound with REST_JSON_FIELDS as JSON body, instead of `data`
+    template <class T>
+    void json(T const& object) {
+      set_json_type();
+      is_json = false;
+      raw.clear();
+      JsonFields::write(object, raw);
+      raw += '\n';
+    }
+    /**
+     * Streams body written by `streamer` with chunked transfer
+     * encoding, connection is kept alive. With `async`, streamer
+     * runs in Streamers pool and Worker serves other clients
+     * meanwhile - HTTP::ServiceUnavailable is thrown when the pool
+     * is full.
+     */
+    void stream(std::function<void(Writer&)> streamer, bool async=false);
+    void stream_async(std::function<void(Writer&)> streamer);
+
+    //! gives socket to `streamer`, connection is closed when it returns
     void stream(std::function<void(int)> streamer, bool async=false);
     void stream_async(std::function<void(int)> streamer);
+    //! sends `length` bytes of `file` from `offset` as body, without reading it
+    void send_file(File::shared const& file, off_t offset, size_t length);
 
     Json::Value data;
+    //! format `data` is sent in, negotiated from Accept
+    BodyFormat::Type format = BodyFormat::JSON;
 
 
   private:
-    Response(Request::shared request, std::vector<std::thread>* streamers);
+    Response(Request::shared request);
     Response(Request::shared request, HTTP::Error &error);
     size_t send();
+    void set_json_type();
+    //! sends head of chunked response, body is written to returned writer
+    Writer::shared start_stream(bool async);
+
+    StringView status_line() const;
+    //! appends status line (if not preformatted) and headers, returns where headers start
+    size_t write_head(std::string& content);
+    //! compresses payload, if client accepts it and it is worth it
+    void compress(std::string& payload);
+    //! encoding body should be compressed with, IDENTITY if none
+    Compressor::Encoding encoding();
+    //! adds `header` to Vary, unless it is listed already
+    void vary(StringView const& header);
 
     std::chrono::high_resolution_clock::time_point start_time;
 
-    std::vector<std::thread>* streamers;
+    //! Worker's buffer for status line and headers, reused by every response
+    std::string* head = nullptr;
+    //! Worker's compressor, nullptr when response is not compressed
+    Compressor* compressor = nullptr;
+    //! best encoding client accepts
+    Compressor::Encoding accepted = Compressor::IDENTITY;
+    Connection* connection;
     int handle;
     bool is_json = false;
     bool is_streamed = false;
+    //! body of HEAD response is not sent, only its length
+    bool is_head = false;
+    bool chunked = false;
+
+    File::shared file;
+    off_t file_offset = 0;
+    size_t file_length = 0;
 };
 
 }
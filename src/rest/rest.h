@@ -20,6 +20,42 @@
 #define WORKER_STREAMERS 4
 #endif
 
+#ifndef SERVER_STREAMERS_QUEUE_SIZE
+#define SERVER_STREAMERS_QUEUE_SIZE 64
+#endif
+
+#ifndef SERVER_KEEPALIVE_REQUESTS
+#define SERVER_KEEPALIVE_REQUESTS 1000
+#endif
+
+#ifndef SERVER_KEEPALIVE_TIMEOUT
+#define SERVER_KEEPALIVE_TIMEOUT 15
+#endif
+
+#ifndef SERVER_LINGER_TIMEOUT
+#define SERVER_LINGER_TIMEOUT 5
+#endif
+
+#ifndef SERVER_COMPRESSION_LEVEL
+#define SERVER_COMPRESSION_LEVEL 6
+#endif
+
+#ifndef SERVER_COMPRESSION_MIN_SIZE
+#define SERVER_COMPRESSION_MIN_SIZE 1024
+#endif
+
+#ifndef SERVER_JSON_SEGMENT_SIZE
+#define SERVER_JSON_SEGMENT_SIZE 262144
+#endif
+
+#ifndef SERVER_MAX_BODY_SIZE
+#define SERVER_MAX_BODY_SIZE 8388608
+#endif
+
+#ifndef SERVER_QUEUE_SIZE
+#define SERVER_QUEUE_SIZE 1024
+#endif
+
 #ifdef SERVER_DISPATCHER_lc
 #define SERVER_DISPATCHER Dispatchers::LeastConnections
 #endif
@@ -32,6 +68,18 @@
 #define SERVER_DISPATCHER Dispatchers::Uniform
 #endif
 
+#ifdef SERVER_DISPATCHER_p2
+#define SERVER_DISPATCHER Dispatchers::PowerOfTwo
+#endif
+
+#ifdef SERVER_DISPATCHER_ll
+#define SERVER_DISPATCHER Dispatchers::LeastLatency
+#endif
+
+#ifdef SERVER_DISPATCHER_ws
+#define SERVER_DISPATCHER Dispatchers::WorkStealing
+#endif
+
 #ifndef SERVER_DISPATCHER
 #define SERVER_DISPATCHER Dispatchers::LeastConnections
 #endif
@@ -43,6 +91,10 @@
 #include <signal.h>
 
 #include "exceptions.h"
+#include "connection.h"
+#include "reaper.h"
+#include "streamers.h"
+#include "json_writer.h"
 #include "server.h"
 
 /// \file
@@ -66,6 +118,16 @@ void main_stop_server(int a = 0) {
 int main(int argc, char **argv) {
   signal(SIGINT, main_stop_server);
 
+  REST::Connection::MAX_REQUESTS = SERVER_KEEPALIVE_REQUESTS;
+  REST::Connection::IDLE_TIMEOUT = SERVER_KEEPALIVE_TIMEOUT;
+  REST::Worker::QUEUE_SIZE = SERVER_QUEUE_SIZE;
+  REST::Reaper::TIMEOUT = SERVER_LINGER_TIMEOUT;
+  REST::Streamers::QUEUE_SIZE = SERVER_STREAMERS_QUEUE_SIZE;
+  REST::Compressor::LEVEL = SERVER_COMPRESSION_LEVEL;
+  REST::Compressor::MIN_SIZE = SERVER_COMPRESSION_MIN_SIZE;
+  REST::JsonWriter::SEGMENT_SIZE = SERVER_JSON_SEGMENT_SIZE;
+  REST::Parser::MAX_BODY_SIZE = SERVER_MAX_BODY_SIZE;
+
 #ifndef SERVER_PATH
   std::cout << "Listening on " << STR(SERVER_BIND) << ":" << SERVER_PORT << ", " << SERVER_WORKERS << " workers (" << SERVER_WORKERS * WORKER_STREAMERS << " streamers), " << STR(SERVER_DISPATCHER) << "\n";
   server_instance = new REST::Server(STR(SERVER_BIND), SERVER_PORT, new REST::SERVER_DISPATCHER(SERVER_WORKERS, WORKER_STREAMERS));
@@ -76,6 +138,14 @@ int main(int argc, char **argv) {
 
   ::routes(server_instance->router());
 
+#if defined(SERVER_REUSEPORT) && !defined(SERVER_PATH)
+#ifdef SERVER_CPU_AFFINITY
+  server_instance->reuse_port(true);
+#else
+  server_instance->reuse_port(false);
+#endif
+#endif
+
   server_instance->run();
 
   return 0;
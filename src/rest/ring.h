@@ -0,0 +1,128 @@
+#ifndef REST_CPP_RING_H
+#define REST_CPP_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace REST {
+
+/**
+ * Ring is bounded, lock-free queue. Any number of threads may
+ * push to it and pop from it at the same time - every cell has
+ * its own sequence number telling whether it is ready to be
+ * written or read, so producers and consumers only contend on
+ * head or tail index (D. Vyukov's bounded MPMC queue).
+ *
+ * Capacity is rounded up to power of two.
+ *
+ * @private
+ * @see Worker
+ */
+template <class T>
+class Ring final {
+
+  public:
+    Ring(size_t capacity) {
+      size_t size = 2;
+      while (size < capacity)
+        size <<= 1;
+
+      cells = std::vector<Cell>(size);
+      for (size_t i = 0; i < size; i++)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+
+      mask = size - 1;
+      head.store(0, std::memory_order_relaxed);
+      tail.store(0, std::memory_order_relaxed);
+    }
+
+    Ring(Ring const&) = delete;
+    Ring& operator=(Ring const&) = delete;
+
+    //! returns false when ring is full
+    bool push(T const& value) {
+      size_t position = tail.load(std::memory_order_relaxed);
+
+      while (true) {
+        Cell& cell = cells[position & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        if (difference == 0) {
+          if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            cell.value = value;
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        } else
+        if (difference < 0) {
+          return false;
+        } else {
+          position = tail.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    //! returns false when ring is empty
+    bool pop(T& value) {
+      size_t position = head.load(std::memory_order_relaxed);
+
+      while (true) {
+        Cell& cell = cells[position & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        if (difference == 0) {
+          if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            value = cell.value;
+            cell.sequence.store(position + mask + 1, std::memory_order_release);
+            return true;
+          }
+        } else
+        if (difference < 0) {
+          return false;
+        } else {
+          position = head.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    //! approximate, exact only when nobody pushes or pops
+    size_t size() const {
+      size_t t = tail.load(std::memory_order_acquire);
+      size_t h = head.load(std::memory_order_acquire);
+      return t > h ? t - h : 0;
+    }
+
+    bool empty() const {
+      return size() == 0;
+    }
+
+  private:
+    const static size_t CACHE_LINE = 64;
+
+    struct Cell {
+      std::atomic<size_t> sequence;
+      T value;
+
+      Cell() : sequence(0), value() {}
+      Cell(Cell const& other) : sequence(other.sequence.load()), value(other.value) {}
+    };
+
+    // head and tail are kept on separate cache lines, so
+    // producers do not invalidate consumer's one
+    char padding0[CACHE_LINE];
+    std::atomic<size_t> tail;
+    char padding1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> head;
+    char padding2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    std::vector<Cell> cells;
+    size_t mask;
+};
+
+}
+
+#endif
@@ -5,9 +5,11 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 namespace REST {
   Router::Node* Router::root = new Router::Node();
+  Router::Table Router::table;
 
   Router::Router() {
   }
@@ -28,14 +30,47 @@ namespace REST {
 
 
   Service::shared Router::find(Request::shared request, int worker_id) {
-    Node* node = unify(request->path, request->parameters);
+    auto route = table.match(*request);
 
-    if (node == nullptr)
+    if (route == nullptr || route->services.empty())
       return nullptr;
 
-    Service::shared service = node->find_service(worker_id);
+    return route->services[worker_id];
+  }
+
+  Router::Route const* Router::route(Request& request) {
+    return table.match(request);
+  }
+
+  void Router::compile(size_t workers) {
+    table.compile(root, workers);
+  }
+
+  void Router::Route::instantiate(size_t workers) {
+    if (!factory || services.size() == workers)
+      return;
+
+    services.clear();
+    for (size_t i = 0; i < workers; i++)
+      services.push_back(factory());
+  }
+
+  void Router::mount(std::string const& path, StatelessService::shared service, bool exact) {
+    Router::Node* node = Router::Node::from_path(path);
+    node->end()->add_service(service);
+    add_route(path, node, exact);
+  }
+
+  void Router::add_route(std::string const& path, Node* node, bool exact) {
+    root->merge(node);
+
+    if (exact)
+      return;
 
-    return service;
+    Router::Node* splat_node = Router::Node::from_path(path == "/" ? "/*" : (path+"/*"));
+    splat_node->end()->route = node->end()->route;
+
+    root->merge(splat_node);
   }
 
   void Router::match(std::string const& path, LambdaService::function lambda) {
@@ -54,12 +89,6 @@ namespace REST {
     children.clear();
   }
 
-  Service::shared Router::Node::find_service(int worker_id) {
-    if (service.empty())
-      return nullptr;
-    return service[worker_id];
-  }
-
   std::string Router::Node::uri() {
     std::string address;
     Node* previous = this;
@@ -103,7 +132,12 @@ namespace REST {
 
   void Router::Node::print(int level) {
     std::cout << std::string(level * 2, ' ') << "/" << path;
-    if (!service.empty()) {
+    if (route && route->stateless) {
+      std::cout << " - stateless";
+    } else
+    if (route && !route->services.empty()) {
+      auto const& service = route->services;
+
       if (dynamic_cast< LambdaService* >(service[0].get()) != nullptr) {
         std::cout << " - lambda";
       } else
@@ -132,8 +166,8 @@ namespace REST {
 
   bool Router::Node::merge(Router::Node* const path) {
     if (Router::Node::equal(path, this)) {
-      if (path->service.size() > 0) {
-        service = path->service;
+      if (path->route) {
+        route = path->route;
       }
 
       std::vector< Node* > common_paths(path->children.size());
@@ -162,10 +196,6 @@ namespace REST {
     return true;
   }
 
-  Router::Node* Router::unify(std::string const& path, std::unordered_map<std::string, std::string>& params) {
-    return root->unify(root, path.empty() ? "/" : path, params);
-  }
-
   bool Router::Node::is_splat() {
     return path[0] == '*';
   }
@@ -174,70 +204,6 @@ namespace REST {
     return parent == nullptr;
   }
 
-  Router::Node* Router::Node::unify(Router::Node* const& root, std::string const& path, std::unordered_map<std::string, std::string>& params) {
-    Node* node = from_path(path);
-    Node* match = unify(root, node, params);
-
-    delete node;
-
-    // if (match != nullptr) {
-    //   std::cout << "Matched '"<< path <<"' to '"<<match->uri()<<"'\n";
-    // }
-
-    return match;
-  }
-
-  Router::Node* Router::Node::unify(Router::Node* const& root, Router::Node* const path, std::unordered_map<std::string, std::string>& params) {
-    if (Router::Node::unifiable(root, path)) {
-      if ((root->is_last() && (path->is_last() || root->is_splat())) ||
-          (path->is_last())) {
-        return root;
-      } else
-      if (root->is_last() && !path->is_last()) {
-        return nullptr;
-      }
-    }
-
-    Node* match;
-
-    for (auto next : root->children) {
-      if (!Router::Node::unifiable(next, path->next()))
-        continue;
-
-      if ((match = unify(next, path->next(), params)) != nullptr) {
-        if (match->service.empty())
-          continue;
-        next->inject(path->next(), params);
-        return match;
-      }
-    }
-
-    return nullptr;
-  }
-
-  void Router::Node::inject(Router::Node* const& rhs, std::unordered_map<std::string, std::string>& params) {
-    if (path[0] == ':') {
-      params[path.substr(1)] = Utils::uri_decode(rhs->path);
-    } else
-    if (path[0] == '*') {
-      int i = 1;
-      std::string splat;
-      Node* current = rhs;
-      while (true) {
-        std::string d = Utils::uri_decode(current->path);
-        splat += d;
-        params[std::to_string(i++)] = d;
-        if (!current->is_last()) {
-          splat += "/";
-        } else {
-          break;
-        }
-        current = current->next();
-      };
-      params["0"] = splat;
-    }
-  }
-
   Router::Node* Router::Node::from_path(std::string const& p) {
     std::string path = ((!p.empty()) && (p[0] != '/')) ? "/" + p : p;
     size_t position_of_dot = path.find_last_of(".");
@@ -272,4 +238,171 @@ namespace REST {
 
     return root;
   }
+
+  /**
+   * Request path split into segments. Segments are separated
+   * by slashes and by last dot in path (so `/task/5.json` is
+   * `task`, `5`, `json`), empty segments are skipped.
+   */
+  struct Router::Table::Path {
+    const char* data;
+    size_t size;
+    size_t dot;
+
+    bool is_separator(size_t i) const {
+      return data[i] == '/' || i == dot;
+    }
+
+    bool next(size_t position, size_t& start, size_t& end) const {
+      while (position < size && is_separator(position))
+        position++;
+
+      if (position >= size)
+        return false;
+
+      start = position;
+      while (position < size && !is_separator(position))
+        position++;
+      end = position;
+
+      return true;
+    }
+  };
+
+  uint64_t Router::Table::hash(uint32_t parent, StringView const& segment) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL ^ parent;
+    for (char c : segment) {
+      h ^= static_cast<unsigned char>(c);
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  void Router::Table::compile(Node* const& root, size_t workers) {
+    std::vector< Node* > order;
+    size_t statics = 0;
+
+    entries.clear();
+
+    // breadth first, so children of every node are next to each other
+    order.push_back(root);
+    entries.push_back(Entry { 0, 0, 0, false, false, StringView(), root->route.get() });
+
+    for (size_t i = 0; i < order.size(); i++) {
+      entries[i].first_child = order.size();
+
+      if (order[i]->route)
+        order[i]->route->instantiate(workers);
+
+      for (auto child : order[i]->children) {
+        Entry entry { 0, 0, 0, false, child->is_splat(), StringView(child->path), child->route.get() };
+
+        if (child->is_splat()) {
+          entries[i].has_splat = true;
+        } else
+        if (child->path[0] == ':') {
+          entry.name = entry.name.substr(1);
+          entries[i].params++;
+        } else {
+          entries[i].statics++;
+          statics++;
+        }
+
+        order.push_back(child);
+        entries.push_back(entry);
+      }
+    }
+
+    // open addressing hash of static segments
+    size_t capacity = 16;
+    while (capacity < statics * 2)
+      capacity <<= 1;
+
+    edges.assign(capacity, Edge { 0, UINT32_MAX, 0 });
+    edges_mask = capacity - 1;
+
+    for (uint32_t i = 0; i < entries.size(); i++) {
+      for (uint32_t c = entries[i].first_child; c < entries[i].first_child + entries[i].statics; c++) {
+        uint64_t h = hash(i, entries[c].name);
+        size_t slot = h & edges_mask;
+
+        while (edges[slot].parent != UINT32_MAX)
+          slot = (slot + 1) & edges_mask;
+
+        edges[slot] = Edge { h, i, c };
+      }
+    }
+  }
+
+  uint32_t Router::Table::find_static(uint32_t parent, StringView const& segment, uint64_t h) const {
+    for (size_t slot = h & edges_mask; edges[slot].parent != UINT32_MAX; slot = (slot + 1) & edges_mask) {
+      Edge const& edge = edges[slot];
+      if (edge.hash == h && edge.parent == parent && entries[edge.child].name == segment)
+        return edge.child;
+    }
+    return UINT32_MAX;
+  }
+
+  bool Router::Table::descend(uint32_t child, Path const& path, size_t position, Request& request, uint32_t& result) const {
+    // nodes without services are only part of longer routes
+    return match(child, path, position, request, result) &&
+      entries[result].route != nullptr && !entries[result].route->empty();
+  }
+
+  Router::Route const* Router::Table::match(Request& request) const {
+    if (entries.empty())
+      return nullptr;
+
+    const char* dot = static_cast<const char*>(memrchr(request.path.data(), '.', request.path.size()));
+    Path path { request.path.data(), request.path.size(), dot ? dot - request.path.data() : StringView::npos };
+
+    uint32_t result;
+    request.captures_count = 0;
+
+    if (!match(0, path, 0, request, result))
+      return nullptr;
+
+    return entries[result].route;
+  }
+
+  bool Router::Table::match(uint32_t index, Path const& path, size_t position, Request& request, uint32_t& result) const {
+    Entry const& entry = entries[index];
+    size_t start, end;
+    bool more = path.next(position, start, end);
+    bool last = entry.statics + entry.params == 0 && !entry.has_splat;
+
+    if ((last && (!more || entry.is_splat)) || !more) {
+      result = index;
+      return true;
+    }
+
+    if (last)
+      return false;
+
+    StringView segment(path.data + start, end - start);
+
+    // static segment is tried first, then parameters and splat
+    if (entry.statics > 0) {
+      uint32_t child = find_static(index, segment, hash(index, segment));
+      if (child != UINT32_MAX && descend(child, path, end, request, result))
+        return true;
+    }
+
+    uint32_t params = entry.first_child + entry.statics;
+
+    for (uint32_t c = params; c < params + entry.params; c++) {
+      if (descend(c, path, end, request, result)) {
+        request.capture(entries[c].name, segment, false);
+        return true;
+      }
+    }
+
+    if (entry.has_splat && descend(params + entry.params, path, end, request, result)) {
+      request.capture(StringView(), StringView(segment.data(), path.size - start), true);
+      return true;
+    }
+
+    return false;
+  }
 }
@@ -7,8 +7,10 @@
 #include <map>
 #include <functional>
 #include <vector>
+#include <cstdint>
 #include "service.h"
 #include "lambda_service.h"
+#include "stateless_service.h"
 #include "worker.h"
 
 namespace REST {
@@ -21,6 +23,24 @@ namespace REST {
  * @see Service
  */
 class Router {
+  public:
+    /**
+     * Services of single route - either one Service per Worker,
+     * created by factory when routes are compiled, or single
+     * StatelessService shared by all Workers.
+     */
+    class Route {
+      public:
+        typedef std::shared_ptr<Route> shared;
+
+        std::function< Service::shared() > factory;
+        std::vector< Service::shared > services;
+        StatelessService::shared stateless;
+
+        bool empty() const { return !factory && !stateless; }
+        void instantiate(size_t workers);
+    };
+
   private:
     class Node {
       friend class Router;
@@ -29,29 +49,25 @@ class Router {
         Node(std::string p, Node* const& pr);
         ~Node();
 
-        Node* unify(Node* const& root, std::string const& path, std::unordered_map<std::string, std::string>& params);
-        Node* unify(Node* const& root, Node* const path, std::unordered_map<std::string, std::string>& params);
         bool merge(Node* const path);
         static Node* from_path(std::string const& path);
 
-        void inject(Node* const& rhs, std::unordered_map<std::string, std::string>& params);
-
+        //! lambda is shared, but it runs on LambdaService of each Worker
         void add_service(std::shared_ptr<LambdaService> srv) {
-          service.clear();
-          service.resize(Worker::POOL_SIZE);
-
-          for (int i = 0; i < Worker::POOL_SIZE; i++)
-            service[i] = std::make_shared<LambdaService>(srv);
+          route = std::make_shared<Route>();
+          route->factory = [srv] () -> Service::shared { return std::make_shared<LambdaService>(srv); };
         }
 
         template <class T>
         void add_service() {
-          service.clear();
-          service.resize(Worker::POOL_SIZE);
-          for (int i = 0; i < Worker::POOL_SIZE; i++)
-            service[i] = std::make_shared<T>();
+          route = std::make_shared<Route>();
+          route->factory = [] () -> Service::shared { return std::make_shared<T>(); };
         };
-        Service::shared find_service(int worker_id);
+
+        void add_service(StatelessService::shared srv) {
+          route = std::make_shared<Route>();
+          route->stateless = srv;
+        }
 
         bool is_root();
         bool is_last();
@@ -83,20 +99,6 @@ class Router {
           }
         } less;
 
-        static struct Unifiable {
-          bool operator()(const Node* a, const Node* b) const {
-            if (a == nullptr || b == nullptr)
-              return false;
-
-            if (!b->path.empty() && (b->path[0] == '*' || b->path[0] == ':'))
-              return false;
-            if (!a->path.empty() && (a->path[0] == '*' || a->path[0] == ':'))
-              return true;
-
-            return a->path == b->path;
-          }
-        } unifiable;
-
         static struct Equal {
           bool operator()(const Node* a, const Node* b) const {
             return (!less(a,b)) && (!less(b,a));
@@ -108,31 +110,75 @@ class Router {
         Node* parent = nullptr;
         std::set<Node*, Less> children;
 
-        std::vector< Service::shared > service;
+        Route::shared route;
+    };
+
+    /**
+     * Table is immutable, contiguous form of routes tree, compiled
+     * when Server starts. Children of every node are stored next to
+     * each other - static segments first, then parameters, then splat.
+     * Static segments are found by hash of parent and segment name.
+     *
+     * Matching does not allocate - parameters are stored in Request
+     * as slices of its path.
+     */
+    class Table {
+      public:
+        void compile(Node* const& root, size_t workers);
+        Route const* match(Request& request) const;
+
+      private:
+        struct Entry {
+          uint32_t first_child;
+          uint32_t statics;
+          uint32_t params;
+          bool has_splat;
+          bool is_splat;
+          StringView name;
+          Route const* route;
+        };
+
+        struct Edge {
+          uint64_t hash;
+          uint32_t parent;
+          uint32_t child;
+        };
+
+        struct Path;
+
+        uint32_t find_static(uint32_t parent, StringView const& segment, uint64_t hash) const;
+        bool match(uint32_t index, Path const& path, size_t position, Request& request, uint32_t& result) const;
+        bool descend(uint32_t child, Path const& path, size_t position, Request& request, uint32_t& result) const;
+
+        static uint64_t hash(uint32_t parent, StringView const& segment);
+
+        std::vector< Entry > entries;
+        std::vector< Edge > edges;
+        uint64_t edges_mask = 0;
     };
 
   public:
     static Router* instance();
     static Service::shared find(Request::shared, int);
+    //! route matching request path, nullptr if there is none
+    static Route const* route(Request& request);
+    //! compiles routes and creates Services of every Worker
+    static void compile(size_t workers);
 
 
+    //! Inline Service, instantiated for every Worker like Resources
     void match(std::string const &, LambdaService::function);
 
     template <class R>
     void mount(std::string const& path, bool exact) {
       Router::Node* node = Router::Node::from_path(path);
       node->end()->add_service<R>();
-      root->merge(node);
-
-      if (exact)
-        return;
-
-      Router::Node* splat_node = Router::Node::from_path(path == "/" ? "/*" : (path+"/*"));
-      splat_node->end()->service = node->end()->service;
-
-      root->merge(splat_node);
+      add_route(path, node, exact);
     }
 
+    //! mounts single instance shared by all Workers
+    void mount(std::string const& path, StatelessService::shared service, bool exact = false);
+
     template <class R>
     void mount(std::string const& path) {
       mount<R>(path, false);
@@ -173,7 +219,7 @@ class Router {
     ~Router();
 
   private:
-    static Node* unify(std::string const&, std::unordered_map<std::string, std::string>&);
+    void add_route(std::string const& path, Node* node, bool exact);
 
     template <class R, int N>
     static std::string to_path() {
@@ -222,6 +268,7 @@ class Router {
     Router();
 
     static Node* root;
+    static Table table;
 };
 
 }
@@ -0,0 +1,267 @@
+#include "scanner.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCANNER_X86
+#include <immintrin.h>
+#endif
+
+namespace REST {
+
+Scanner::Set::Set(const char* c) : size(0) {
+  while (*c && size < 16)
+    chars[size++] = *c++;
+  for (int i = size; i < 16; i++)
+    chars[i] = size ? chars[0] : 0;
+}
+
+namespace {
+
+typedef const char* (*find_char_function)(const char*, const char*, char);
+typedef const char* (*find_set_function)(const char*, const char*, Scanner::Set const&);
+typedef const char* (*find_escape_function)(const char*, const char*);
+typedef void (*classify_function)(const char*, Scanner::Block&);
+
+struct Implementation {
+  const char* name;
+  find_char_function find_char;
+  find_set_function find_set;
+  find_escape_function find_escape;
+  classify_function classify;
+};
+
+const char* find_char_scalar(const char* p, const char* end, char c) {
+  const void* found = memchr(p, c, end - p);
+  return found ? static_cast<const char*>(found) : end;
+}
+
+const char* find_set_scalar(const char* p, const char* end, Scanner::Set const& set) {
+  for (; p < end; p++)
+    for (int i = 0; i < set.size; i++)
+      if (*p == set.chars[i])
+        return p;
+  return end;
+}
+
+// quote, backslash and control characters
+const char* find_escape_scalar(const char* p, const char* end) {
+  for (; p < end; p++)
+    if (*p == '"' || *p == '\\' || static_cast<unsigned char>(*p) < 0x20)
+      return p;
+  return end;
+}
+
+void classify_scalar(const char* p, Scanner::Block& block) {
+  block = Scanner::Block { 0, 0, 0, 0 };
+
+  for (int i = 0; i < 64; i++) {
+    uint64_t bit = uint64_t(1) << i;
+
+    switch (p[i]) {
+      case '"': block.quotes |= bit; break;
+      case '\\': block.backslashes |= bit; break;
+      case '{': case '}': case '[': case ']': case ':': case ',': block.operators |= bit; break;
+      case ' ': case '\t': case '\n': case '\r': block.whitespace |= bit; break;
+    }
+  }
+}
+
+#ifdef SCANNER_X86
+
+__attribute__((target("sse4.2")))
+const char* find_char_sse42(const char* p, const char* end, char c) {
+  const __m128i needle = _mm_set1_epi8(c);
+
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+
+  return find_char_scalar(p, end, c);
+}
+
+__attribute__((target("sse4.2")))
+const char* find_set_sse42(const char* p, const char* end, Scanner::Set const& set) {
+  const __m128i needles = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.chars));
+
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int index = _mm_cmpestri(needles, set.size, chunk, 16,
+      _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+    if (index < 16)
+      return p + index;
+  }
+
+  return find_set_scalar(p, end, set);
+}
+
+__attribute__((target("sse4.2")))
+const char* find_escape_sse42(const char* p, const char* end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+
+  for (; end - p >= 16; p += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // unsigned byte is below 0x20 when min(byte, 0x1f) == byte
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+
+    int mask = _mm_movemask_epi8(matches);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+
+  return find_escape_scalar(p, end);
+}
+
+// characters are looked up by their low nibble (-1 matches nothing,
+// bytes above 0x7f are looked up as 0 and never match either)
+#define WHITESPACE_TABLE ' ', -1, -1, -1, -1, -1, -1, -1, -1, '\t', '\n', -1, -1, '\r', -1, -1
+#define BRACES_TABLE -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, ':', '{', ',', '}', -1, -1
+#define BRACKETS_TABLE -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, '[', -1, ']', -1, -1
+
+__attribute__((target("sse4.2")))
+void classify_sse42(const char* p, Scanner::Block& block) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i whitespace = _mm_setr_epi8(WHITESPACE_TABLE);
+  const __m128i braces = _mm_setr_epi8(BRACES_TABLE);
+  const __m128i brackets = _mm_setr_epi8(BRACKETS_TABLE);
+
+  block = Scanner::Block { 0, 0, 0, 0 };
+
+  for (int i = 0; i < 4; i++) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+    __m128i operators = _mm_or_si128(_mm_cmpeq_epi8(_mm_shuffle_epi8(braces, chunk), chunk),
+                                     _mm_cmpeq_epi8(_mm_shuffle_epi8(brackets, chunk), chunk));
+
+    block.quotes |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << (i * 16);
+    block.backslashes |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)))) << (i * 16);
+    block.operators |= uint64_t(uint16_t(_mm_movemask_epi8(operators))) << (i * 16);
+    block.whitespace |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_shuffle_epi8(whitespace, chunk), chunk)))) << (i * 16);
+  }
+}
+
+__attribute__((target("avx2")))
+const char* find_char_avx2(const char* p, const char* end, char c) {
+  const __m256i needle = _mm256_set1_epi8(c);
+
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+
+  return find_char_sse42(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char* find_set_avx2(const char* p, const char* end, Scanner::Set const& set) {
+  __m256i needles[16];
+  for (int i = 0; i < set.size; i++)
+    needles[i] = _mm256_set1_epi8(set.chars[i]);
+
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i matches = _mm256_cmpeq_epi8(chunk, needles[0]);
+    for (int i = 1; i < set.size; i++)
+      matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(chunk, needles[i]));
+
+    unsigned int mask = _mm256_movemask_epi8(matches);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+
+  return find_set_sse42(p, end, set);
+}
+
+__attribute__((target("avx2")))
+const char* find_escape_avx2(const char* p, const char* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1f);
+
+  for (; end - p >= 32; p += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash));
+    matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+
+    unsigned int mask = _mm256_movemask_epi8(matches);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+
+  return find_escape_sse42(p, end);
+}
+
+__attribute__((target("avx2")))
+void classify_avx2(const char* p, Scanner::Block& block) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i whitespace = _mm256_setr_epi8(WHITESPACE_TABLE, WHITESPACE_TABLE);
+  const __m256i braces = _mm256_setr_epi8(BRACES_TABLE, BRACES_TABLE);
+  const __m256i brackets = _mm256_setr_epi8(BRACKETS_TABLE, BRACKETS_TABLE);
+
+  block = Scanner::Block { 0, 0, 0, 0 };
+
+  for (int i = 0; i < 2; i++) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 32));
+    __m256i operators = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_shuffle_epi8(braces, chunk), chunk),
+                                        _mm256_cmpeq_epi8(_mm256_shuffle_epi8(brackets, chunk), chunk));
+
+    block.quotes |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)))) << (i * 32);
+    block.backslashes |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)))) << (i * 32);
+    block.operators |= uint64_t(uint32_t(_mm256_movemask_epi8(operators))) << (i * 32);
+    block.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_shuffle_epi8(whitespace, chunk), chunk)))) << (i * 32);
+  }
+}
+
+#endif
+
+Implementation select() {
+#ifdef SCANNER_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    return Implementation { "avx2", find_char_avx2, find_set_avx2, find_escape_avx2, classify_avx2 };
+
+  if (__builtin_cpu_supports("sse4.2"))
+    return Implementation { "sse4.2", find_char_sse42, find_set_sse42, find_escape_sse42, classify_sse42 };
+#endif
+
+  return Implementation { "scalar", find_char_scalar, find_set_scalar, find_escape_scalar, classify_scalar };
+}
+
+Implementation const& selected() {
+  static Implementation implementation = select();
+  return implementation;
+}
+
+}
+
+const char* Scanner::find(const char* begin, const char* end, char c) {
+  return selected().find_char(begin, end, c);
+}
+
+const char* Scanner::find(const char* begin, const char* end, Set const& set) {
+  return selected().find_set(begin, end, set);
+}
+
+const char* Scanner::find_escape(const char* begin, const char* end) {
+  return selected().find_escape(begin, end);
+}
+
+void Scanner::classify(const char* data, Block& block) {
+  selected().classify(data, block);
+}
+
+const char* Scanner::implementation() {
+  return selected().name;
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef REST_CPP_SCANNER_H
+#define REST_CPP_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace REST {
+
+/**
+ * Scanner finds delimiters in request buffers 16 or 32 bytes
+ * at a time. Implementation (AVX2, SSE4.2 or portable scalar
+ * one) is chosen once, on startup, by checking what current
+ * CPU supports.
+ *
+ * Every function returns pointer to first matching character
+ * or `end` when there is none.
+ *
+ * @private
+ * @see Parser
+ */
+class Scanner final {
+
+  public:
+    /**
+     * Set of up to 16 characters to look for.
+     */
+    class Set {
+      public:
+        Set(const char* chars);
+
+        char chars[16];
+        int size;
+    };
+
+    /**
+     * Characters of 64 bytes of JSON document, bit n of every mask
+     * stands for byte n.
+     */
+    struct Block {
+      uint64_t quotes;
+      uint64_t backslashes;
+      //! { } [ ] : ,
+      uint64_t operators;
+      uint64_t whitespace;
+    };
+
+    static const char* find(const char* begin, const char* end, char c);
+    static const char* find(const char* begin, const char* end, Set const& set);
+
+    //! finds first character which has to be escaped in JSON string
+    static const char* find_escape(const char* begin, const char* end);
+
+    //! classifies 64 bytes at `data`
+    static void classify(const char* data, Block& block);
+
+    //! name of implementation in use
+    static const char* implementation();
+};
+
+}
+
+#endif
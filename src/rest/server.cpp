@@ -48,13 +48,20 @@ Server::Server(std::string address, int port, Dispatcher* d) : dispatcher(d) {
     throw PortInUseError();
 }
 
+void Server::reuse_port(bool a) {
+  reuseport = true;
+  affinity = a;
+}
+
 Server::~Server() {
   is_running = false;
 
   delete dispatcher;
 
-  freeaddrinfo(host_info_list);
-  close(handle);
+  if (host_info_list != nullptr)
+    freeaddrinfo(host_info_list);
+  if (handle != -1)
+    close(handle);
 
 #ifdef SERVER_PATH
   unlink(STR(SERVER_PATH));
@@ -64,8 +71,21 @@ Server::~Server() {
 void Server::run() {
   int status;
 
+  Router::compile(dispatcher->size());
   router()->print();
 
+  if (reuseport && host_info_list != nullptr) {
+    // workers bind the same address on their own
+    close(handle);
+    handle = -1;
+
+    dispatcher->listen(host_info_list, affinity);
+
+    while (is_running)
+      pause();
+    return;
+  }
+
   status = listen(handle, SOMAXCONN);
   if (status == -1)
     throw ServerError();
@@ -15,8 +15,12 @@
 #include "exceptions.h"
 #include "dispatchers/roundrobin.h"
 #include "dispatchers/leastconnections.h"
+#include "dispatchers/leastlatency.h"
 #include "dispatchers/uniform.h"
+#include "dispatchers/poweroftwo.h"
+#include "dispatchers/workstealing.h"
 #include "router.h"
+#include "static_files.h"
 
 namespace REST {
 
@@ -36,13 +40,26 @@ class Server {
     void run();
     Router* router();
 
+    /**
+     * Lets every Worker accept clients on its own SO_REUSEPORT
+     * socket, so kernel spreads connections between them and
+     * there is no single accepting thread. Has no effect for
+     * Unix sockets.
+     *
+     * @param affinity pin Workers to CPUs and pass connection
+     *  to Worker on CPU which received it
+     */
+    void reuse_port(bool affinity = false);
+
   private:
     Dispatcher* dispatcher;
 
     bool is_running = true;
+    bool reuseport = false;
+    bool affinity = false;
 
     struct addrinfo host_info;
-    struct addrinfo* host_info_list;
+    struct addrinfo* host_info_list = nullptr;
     int handle;
 };
 
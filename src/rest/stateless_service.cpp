@@ -0,0 +1,44 @@
+#include "stateless_service.h"
+
+namespace REST {
+
+StatelessService::~StatelessService() {
+}
+
+void StatelessService::create(Request& request, Response& response) {
+  throw HTTP::MethodNotAllowed();
+}
+
+void StatelessService::read(Request& request, Response& response) {
+  throw HTTP::MethodNotAllowed();
+}
+
+void StatelessService::update(Request& request, Response& response) {
+  throw HTTP::MethodNotAllowed();
+}
+
+void StatelessService::destroy(Request& request, Response& response) {
+  throw HTTP::MethodNotAllowed();
+}
+
+void StatelessService::handle(Request& request, Response& response) {
+  switch (request.method) {
+    case Request::Method::POST:
+      create(request, response);
+      break;
+    case Request::Method::GET:
+      read(request, response);
+      break;
+    case Request::Method::PATCH:
+    case Request::Method::PUT:
+      update(request, response);
+      break;
+    case Request::Method::DELETE:
+      destroy(request, response);
+      break;
+    default:
+      throw HTTP::MethodNotAllowed();
+  }
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef REST_CPP_STATELESS_SERVICE_H
+#define REST_CPP_STATELESS_SERVICE_H
+
+#include <memory>
+#include "request.h"
+#include "response.h"
+#include "exceptions.h"
+
+namespace REST {
+
+/**
+ * StatelessService is shared by all Workers - there is single
+ * instance per route, instead of one Service per Worker. Request
+ * and response are passed to its methods rather than kept in its
+ * members, so it must not keep state of any request and it must
+ * be safe to call from many Workers at once.
+ *
+ * Methods are mapped like in Resource. Mount it with
+ * `Router::mount(path, std::make_shared<MyService>())`.
+ */
+class StatelessService {
+  public:
+    typedef std::shared_ptr<StatelessService> shared;
+
+    virtual ~StatelessService();
+
+    //! calls method matching request method
+    virtual void handle(Request& request, Response& response);
+
+    virtual void create(Request& request, Response& response);
+    virtual void read(Request& request, Response& response);
+    virtual void update(Request& request, Response& response);
+    virtual void destroy(Request& request, Response& response);
+};
+
+}
+
+#endif
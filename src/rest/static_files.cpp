@@ -0,0 +1,252 @@
+#include "static_files.h"
+#include "utils.h"
+#include "compressor.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace REST {
+
+static const struct {
+  StringView extension;
+  const char* type;
+} CONTENT_TYPES[] = {
+  { "html", "text/html; charset=utf-8" },
+  { "htm", "text/html; charset=utf-8" },
+  { "css", "text/css; charset=utf-8" },
+  { "js", "application/javascript; charset=utf-8" },
+  { "mjs", "application/javascript; charset=utf-8" },
+  { "json", "application/json; charset=utf-8" },
+  { "map", "application/json; charset=utf-8" },
+  { "txt", "text/plain; charset=utf-8" },
+  { "xml", "application/xml; charset=utf-8" },
+  { "svg", "image/svg+xml" },
+  { "png", "image/png" },
+  { "jpg", "image/jpeg" },
+  { "jpeg", "image/jpeg" },
+  { "gif", "image/gif" },
+  { "webp", "image/webp" },
+  { "ico", "image/x-icon" },
+  { "woff", "font/woff" },
+  { "woff2", "font/woff2" },
+  { "ttf", "font/ttf" },
+  { "wasm", "application/wasm" },
+  { "pdf", "application/pdf" },
+  { "mp4", "video/mp4" },
+  { "webm", "video/webm" }
+};
+
+enum class Range { NONE, SATISFIABLE, UNSATISFIABLE };
+
+static const char* content_type(std::string const& path) {
+  size_t dot = path.rfind('.');
+  size_t slash = path.rfind('/');
+
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    StringView extension(path.data() + dot + 1, path.size() - dot - 1);
+    for (auto const& content_type : CONTENT_TYPES)
+      if (Header::equals(content_type.extension, extension))
+        return content_type.type;
+  }
+
+  return "application/octet-stream";
+}
+
+static StringView trim(const char* begin, const char* end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t'))
+    end--;
+  return StringView(begin, end - begin);
+}
+
+//! whether any of listed entity tags is `etag` (weak comparison)
+static bool matches(StringView const& value, std::string const& etag) {
+  const char* position = value.begin();
+
+  while (position < value.end()) {
+    const char* next = static_cast<const char*>(memchr(position, ',', value.end() - position));
+    if (next == nullptr)
+      next = value.end();
+
+    StringView tag = trim(position, next);
+    if (tag.starts_with("W/"))
+      tag = StringView(tag.data() + 2, tag.size() - 2);
+
+    if (tag == "*" || tag == etag)
+      return true;
+
+    position = next + 1;
+  }
+
+  return false;
+}
+
+static bool is_not_modified(Request const& request, File const& file) {
+  auto none_match = request.headers.find(Header::IF_NONE_MATCH);
+  if (none_match != request.headers.end())
+    return matches(none_match->second, file.etag);
+
+  auto modified_since = request.headers.find(Header::IF_MODIFIED_SINCE);
+  if (modified_since != request.headers.end()) {
+    time_t since = Utils::parse_rfc1123_datetime(modified_since->second.str());
+    return since != -1 && file.modified <= since;
+  }
+
+  return false;
+}
+
+//! whether range may be served, file did not change since client got its other part
+static bool is_range_current(Request const& request, File const& file) {
+  auto if_range = request.headers.find(Header::IF_RANGE);
+  if (if_range == request.headers.end())
+    return true;
+
+  return if_range->second == file.etag || if_range->second == file.last_modified;
+}
+
+/**
+ * Parses single byte range of file of `size` bytes, multiple
+ * ranges are not supported and whole file is sent for them.
+ */
+static Range parse_range(StringView const& value, off_t size, off_t& first, off_t& last) {
+  if (!value.starts_with("bytes=") || value.find(',') != StringView::npos)
+    return Range::NONE;
+
+  std::string spec(value.data() + 6, value.size() - 6);
+  const char* position = spec.c_str();
+  char* end;
+
+  // suffix range, last n bytes
+  if (*position == '-') {
+    off_t length = strtoll(position + 1, &end, 10);
+    if (end == position + 1 || *end != '\0')
+      return Range::NONE;
+    if (length == 0 || size == 0)
+      return Range::UNSATISFIABLE;
+
+    first = length < size ? size - length : 0;
+    last = size - 1;
+    return Range::SATISFIABLE;
+  }
+
+  first = strtoll(position, &end, 10);
+  if (end == position || *end != '-' || first < 0)
+    return Range::NONE;
+
+  position = end + 1;
+  if (*position == '\0') {
+    last = size - 1;
+  } else {
+    last = strtoll(position, &end, 10);
+    if (*end != '\0' || last < first)
+      return Range::NONE;
+    if (last >= size)
+      last = size - 1;
+  }
+
+  return first < size ? Range::SATISFIABLE : Range::UNSATISFIABLE;
+}
+
+StaticFiles::StaticFiles(std::string const& r, size_t cache_size) : root(r), cache(cache_size) {
+  while (!root.empty() && root.back() == '/')
+    root.pop_back();
+}
+
+bool StaticFiles::resolve(StringView const& splat, std::string& path) const {
+  std::string relative = Utils::uri_decode(splat);
+  if (relative.find('\0') != std::string::npos)
+    return false;
+
+  path = root;
+
+  // segments are normalized, so changes reported by FileCache match
+  size_t start = 0;
+  while (start < relative.size()) {
+    size_t end = relative.find('/', start);
+    if (end == std::string::npos)
+      end = relative.size();
+
+    if (end - start == 2 && relative.compare(start, 2, "..") == 0)
+      return false;
+
+    if (end > start && !(end - start == 1 && relative[start] == '.')) {
+      path += "/";
+      path.append(relative, start, end - start);
+    }
+
+    start = end + 1;
+  }
+
+  if (relative.empty() || relative.back() == '/')
+    path += "/" + index;
+
+  return true;
+}
+
+void StaticFiles::handle(Request& request, Response& response) {
+  if (request.method != Request::Method::GET && request.method != Request::Method::HEAD)
+    throw HTTP::MethodNotAllowed();
+
+  std::string path;
+  if (!resolve(request.splat(), path))
+    throw HTTP::NotFound();
+
+  File::shared file;
+  const char* encoding = nullptr;
+
+  // precompressed sibling, if client accepts it
+  auto accept_encoding = request.headers.find(Header::ACCEPT_ENCODING);
+  if (accept_encoding != request.headers.end()) {
+    if (Compressor::accepts(accept_encoding->second, "br") && (file = cache.get(path + ".br")))
+      encoding = "br";
+    else
+    if (Compressor::accepts(accept_encoding->second, "gzip") && (file = cache.get(path + ".gz")))
+      encoding = "gzip";
+  }
+
+  if (file == nullptr)
+    file = cache.get(path);
+
+  if (file == nullptr)
+    throw HTTP::NotFound();
+
+  response.headers[Header::CONTENT_TYPE] = content_type(path);
+  response.headers["ETag"] = file->etag;
+  response.headers["Last-Modified"] = file->last_modified;
+  response.headers["Accept-Ranges"] = "bytes";
+  response.headers["Vary"] = "Accept-Encoding";
+  if (encoding != nullptr)
+    response.headers[Header::CONTENT_ENCODING] = encoding;
+
+  if (is_not_modified(request, *file)) {
+    response.status = 304;
+    response.status_message = "Not Modified";
+    return;
+  }
+
+  off_t first = 0;
+  off_t last = file->size - 1;
+
+  auto range = request.headers.find(Header::RANGE);
+  if (range != request.headers.end() && is_range_current(request, *file)) {
+    switch (parse_range(range->second, file->size, first, last)) {
+      case Range::UNSATISFIABLE:
+        response.status = 416;
+        response.status_message = "Range Not Satisfiable";
+        response.headers["Content-Range"] = "bytes */" + std::to_string(file->size);
+        return;
+      case Range::SATISFIABLE:
+        response.status = 206;
+        response.status_message = "Partial Content";
+        response.headers["Content-Range"] = "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(file->size);
+        break;
+      case Range::NONE:
+        break;
+    }
+  }
+
+  response.send_file(file, first, last - first + 1);
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef REST_CPP_STATIC_FILES_H
+#define REST_CPP_STATIC_FILES_H
+
+#include <string>
+
+#include "stateless_service.h"
+#include "file_cache.h"
+
+namespace REST {
+
+/**
+ * StaticFiles serves files from `root` directory. Path matched by
+ * splat is path of file, directories are served with their index.
+ *
+ * File bodies are sent with sendfile() and open files are kept in
+ * FileCache. Range (single one), If-Range, If-None-Match and
+ * If-Modified-Since are supported. When client accepts it,
+ * precompressed `.br` or `.gz` sibling of file is sent instead.
+ *
+ * ~~~~~{.cpp}
+ * r->mount("/assets", std::make_shared<REST::StaticFiles>("public"));
+ * ~~~~~
+ */
+class StaticFiles : public StatelessService {
+  public:
+    StaticFiles(std::string const& root, size_t cache_size = 1024);
+
+    void handle(Request& request, Response& response) override;
+
+    //! file served for directory
+    std::string index = "index.html";
+
+  private:
+    //! path of requested file, false if it is outside of root
+    bool resolve(StringView const& splat, std::string& path) const;
+
+    std::string root;
+    FileCache cache;
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "streamers.h"
+
+#include <csignal>
+
+namespace REST {
+
+size_t Streamers::QUEUE_SIZE = 64;
+
+static const size_t DEFAULT_THREADS = 16;
+
+Streamers* Streamers::start(size_t threads) {
+  static Streamers streamers(threads);
+  return &streamers;
+}
+
+Streamers* Streamers::instance() {
+  return start(DEFAULT_THREADS);
+}
+
+Streamers::Streamers(size_t count) : load(0), capacity(count + QUEUE_SIZE) {
+  for (size_t i = 0; i < count; i++)
+    threads.emplace_back([this] () {
+      work();
+    });
+}
+
+Streamers::~Streamers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_run = false;
+  }
+  available.notify_all();
+
+  for (auto& thread : threads)
+    thread.join();
+}
+
+bool Streamers::reserve() {
+  size_t current = load.load(std::memory_order_relaxed);
+
+  do {
+    if (current >= capacity)
+      return false;
+  } while (!load.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+
+  return true;
+}
+
+void Streamers::run(std::function<void()> stream) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    streams.push_back(std::move(stream));
+  }
+  available.notify_one();
+}
+
+void Streamers::work() {
+  signal(SIGPIPE, SIG_IGN);
+
+  while (true) {
+    std::function<void()> stream;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      available.wait(lock, [this] () { return !streams.empty() || !should_run; });
+
+      if (streams.empty())
+        return;
+
+      stream = std::move(streams.front());
+      streams.pop_front();
+    }
+
+    try {
+      stream();
+    } catch (...) {
+    }
+
+    load.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+}
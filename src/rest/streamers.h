@@ -0,0 +1,62 @@
+#ifndef REST_CPP_STREAMERS_H
+#define REST_CPP_STREAMERS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace REST {
+
+/**
+ * Streamers is fixed pool of threads running asynchronous streams,
+ * shared by all Workers of process. Threads are started with the
+ * pool, never when stream starts.
+ *
+ * At most QUEUE_SIZE streams wait for free thread. When pool and
+ * its queue are full, new stream is refused - reserve() fails and
+ * client gets 503 Service Unavailable, so Worker never waits for
+ * streamers.
+ *
+ * @private
+ * @see Response::stream
+ */
+class Streamers final {
+
+  public:
+    //! streams waiting for free thread
+    static size_t QUEUE_SIZE;
+
+    //! starts pool of `threads` threads, unless it runs already
+    static Streamers* start(size_t threads);
+    static Streamers* instance();
+
+    //! reserves place for one stream, false when pool is full
+    bool reserve();
+    //! runs stream in place reserved before
+    void run(std::function<void()> stream);
+
+  private:
+    Streamers(size_t threads);
+    ~Streamers();
+
+    void work();
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque< std::function<void()> > streams;
+
+    //! streams running or waiting
+    std::atomic<size_t> load;
+    size_t capacity;
+
+    bool should_run = true;
+    std::vector<std::thread> threads;
+};
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef REST_CPP_STRING_VIEW_H
+#define REST_CPP_STRING_VIEW_H
+
+#include <string>
+#include <cstring>
+#include <ostream>
+
+namespace REST {
+
+/**
+ * StringView is non-owning slice of characters, like C++17
+ * std::string_view. Request uses it to refer to parts of
+ * connection buffer without copying them.
+ *
+ * View is valid only as long as memory it points to, for
+ * Request fields it means until request is handled.
+ */
+class StringView {
+
+  public:
+    typedef const char* const_iterator;
+    static const size_t npos = std::string::npos;
+
+    StringView() : ptr(nullptr), len(0) {}
+    StringView(const char* s) : ptr(s), len(s ? strlen(s) : 0) {}
+    StringView(const char* s, size_t l) : ptr(s), len(l) {}
+    StringView(std::string const& s) : ptr(s.data()), len(s.size()) {}
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    size_t length() const { return len; }
+    bool empty() const { return len == 0; }
+
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+
+    char operator[](size_t i) const { return ptr[i]; }
+
+    StringView substr(size_t position, size_t count = npos) const {
+      if (position > len)
+        position = len;
+      if (count > len - position)
+        count = len - position;
+      return StringView(ptr + position, count);
+    }
+
+    size_t find(char c, size_t position = 0) const {
+      if (position >= len)
+        return npos;
+      const void* found = memchr(ptr + position, c, len - position);
+      return found ? static_cast<const char*>(found) - ptr : npos;
+    }
+
+    size_t find(StringView const& s, size_t position = 0) const {
+      if (s.len > len)
+        return npos;
+      for (size_t i = position; i + s.len <= len; i++)
+        if (memcmp(ptr + i, s.ptr, s.len) == 0)
+          return i;
+      return npos;
+    }
+
+    bool starts_with(StringView const& s) const {
+      return len >= s.len && memcmp(ptr, s.ptr, s.len) == 0;
+    }
+
+    int compare(StringView const& s) const {
+      int r = memcmp(ptr, s.ptr, len < s.len ? len : s.len);
+      if (r != 0)
+        return r;
+      return len < s.len ? -1 : (len > s.len ? 1 : 0);
+    }
+
+    bool operator==(StringView const& s) const {
+      return len == s.len && memcmp(ptr, s.ptr, len) == 0;
+    }
+
+    bool operator!=(StringView const& s) const {
+      return !(*this == s);
+    }
+
+    std::string str() const { return std::string(ptr, len); }
+    operator std::string() const { return str(); }
+
+  private:
+    const char* ptr;
+    size_t len;
+};
+
+inline bool operator==(const char* lhs, StringView const& rhs) { return rhs == lhs; }
+inline bool operator==(std::string const& lhs, StringView const& rhs) { return rhs == lhs; }
+inline bool operator!=(const char* lhs, StringView const& rhs) { return rhs != lhs; }
+inline bool operator!=(std::string const& lhs, StringView const& rhs) { return rhs != lhs; }
+
+inline std::ostream& operator<<(std::ostream& os, StringView const& s) {
+  return os.write(s.data(), s.size());
+}
+
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include "utils.h"
 
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 
 namespace REST {
 namespace Utils {
@@ -58,12 +60,16 @@ const static char HEX2DEC[256] =
     /* F */ -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1, -1,-1,-1,-1
 };
 
-std::string uri_decode(const std::string & sSrc) {
+std::string uri_decode(StringView const& sSrc) {
    // Note from RFC1630: "Sequences which start with a percent
    // sign but are not followed by two hexadecimal characters
    // (0-9, A-F) are reserved for future extension"
 
-   const unsigned char * pSrc = (const unsigned char *)sSrc.c_str();
+   // most of names and values are not encoded at all
+   if (sSrc.find('%') == StringView::npos)
+      return sSrc.str();
+
+   const unsigned char * pSrc = (const unsigned char *)sSrc.data();
    const int SRC_LEN = sSrc.length();
    const unsigned char * const SRC_END = pSrc + SRC_LEN;
    // last decodable '%'
@@ -99,15 +105,26 @@ std::string uri_decode(const std::string & sSrc) {
 }
 
 std::string rfc1123_datetime( time_t time ) {
-  struct tm * timeinfo;
+  struct tm timeinfo;
   char buffer [80];
 
-  timeinfo = gmtime ( &time );
-  strftime (buffer,80,"%a, %d %b %Y %H:%M:%S GMT",timeinfo);
+  gmtime_r ( &time, &timeinfo );
+  strftime (buffer,80,"%a, %d %b %Y %H:%M:%S GMT",&timeinfo);
 
   return buffer;
 }
 
+time_t parse_rfc1123_datetime(std::string const& value) {
+  struct tm timeinfo;
+  memset(&timeinfo, 0, sizeof(timeinfo));
+
+  const char* end = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &timeinfo);
+  if (end == nullptr || *end != '\0')
+    return -1;
+
+  return timegm(&timeinfo);
+}
+
 // from http://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
 
 static const std::string base64_chars =
@@ -4,6 +4,7 @@
 #include <ctime>
 #include <string>
 #include <sstream>
+#include "string_view.h"
 
 namespace REST {
 namespace Utils {
@@ -17,11 +18,23 @@ R parse_string(const S& str) {
   return val;
 }
 
+template <>
+inline std::string parse_string<std::string, StringView>(const StringView& str) {
+  return str.str();
+}
+
+template <>
+inline std::string parse_string<std::string, std::string>(const std::string& str) {
+  return str;
+}
+
 std::string random_uuid();
-std::string uri_decode(const std::string& src);
+std::string uri_decode(StringView const& src);
 std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
 std::string base64_decode(std::string const& encoded_string);
 std::string rfc1123_datetime(time_t time);
+//! -1 unless `value` is RFC 1123 date
+time_t parse_rfc1123_datetime(std::string const& value);
 
 }
 }
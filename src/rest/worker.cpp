@@ -1,18 +1,21 @@
 #include "worker.h"
+#include "connection.h"
 #include "service.h"
 #include "router.h"
 
 #include <csignal>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
+#include <sys/socket.h>
 
 namespace REST {
 
-int Worker::POOL_SIZE = 256;
+size_t Worker::QUEUE_SIZE = 1024;
 
-Worker::Worker(int i, int sc, size_t* cc) :
- id(i), streamers_count(sc), clients_count(cc) {
+Worker::Worker(int i, Load* cc) :
+ clients_queue(QUEUE_SIZE), sleeping(false), busy(false), siblings(nullptr), id(i), clients_count(cc) {
   THREAD_NAME("rest-cpp - main thread");
-  *cc = 0;
   server_header = "rest-cpp, worker " + std::to_string(id);
   run();
 }
@@ -25,72 +28,316 @@ void Worker::run() {
 
     signal(SIGPIPE, SIG_IGN);
 
+    time_t last_sweep = time(0);
+
     // while worker is alive
     while (should_run) {
-      Request::client client;
-      {
-        std::unique_lock<std::mutex> queue_lock(clients_queue_lock);
-
-        // wait for new request
-        clients_queue_ready.wait(queue_lock, [this] { return !should_run || !clients_queue.empty(); });
-        client = clients_queue.front();
-        clients_queue.pop();
-      }
+      // announce sleep before last look at queue, so client
+      // pushed meanwhile is either seen here or wakes us up
+      sleeping.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
 
-      if (!should_run)
-        break;
+      // wait for new clients or events on existing ones, wake up
+      // every second to close idle connections if there are any
+      int count = poller.wait(clients_queue.empty() ? (connections.empty() ? -1 : 1000) : 0);
+      sleeping.store(false, std::memory_order_relaxed);
 
-      // make request
-      Request::shared request = Request::make(client);
+      for (int i = 0; i < count; i++) {
+        Poller::Event const& event = poller.event(i);
 
-      Response::shared response(new Response(request, &streamers));
-      response->headers["Server"] = server_header + ", waiting " + std::to_string(*clients_count);
+        if (event.tag == nullptr)
+          poller.drain();
+        else
+        if (event.tag == &listener)
+          accept_clients();
+        else
+          process(static_cast<Connection*>(event.tag), event.events);
+      }
 
-      try {
-        // std::cout << "Request '" << request->path << "' - worker #"<<id<<", handle #"<<request->handle<<"\n";
+      // chunks written by streamers meanwhile
+      if (!streaming.empty()) {
+        std::vector<Connection*> streams(streaming.begin(), streaming.end());
+        for (auto connection : streams)
+          process(connection, 0);
+      }
 
-        make_action(request, response);
+      adopt();
 
-        response->send();
+      if (siblings.load(std::memory_order_relaxed) != nullptr)
+        steal();
 
-      } catch (HTTP::Error &e) {
-        Response::unique error_response(new Response(request, e));
-        error_response->headers.insert(response->headers.begin(), response->headers.end());
-        error_response->send();
+      time_t now = time(0);
+      if (now != last_sweep) {
+        last_sweep = now;
+        for (auto connection : connections)
+          if (connection->is_idle(now) && connection->state != Connection::State::STREAMING)
+            released.push_back(connection);
+        for (auto connection : released) {
+          connections.erase(connection);
+          streaming.erase(connection);
+        }
       }
 
-      if (streamers.size() >= streamers_count) {
-        for (auto& s : streamers)
-          s.join();
-        streamers.clear();
-      }
+      // connections are freed after whole round, as they
+      // may have more than one event pending
+      for (auto connection : released) {
+        delete connection;
 
-      if ((*clients_count) > 0)
-        (*clients_count)--;
+        clients_count->decrement();
+      }
+      released.clear();
     }
 
+    for (auto connection : connections)
+      delete connection;
+    connections.clear();
+
+    if (listener != -1)
+      close(listener);
+
     std::cout << "Stopped worker #" << id << std::endl;
   });
 }
 
+void Worker::adopt() {
+  Request::client client;
+
+  while (clients_queue.pop(client))
+    adopt(client);
+}
+
+void Worker::adopt(Request::client const& client) {
+  try {
+    connections.insert(new Connection(client, &poller));
+  } catch (Exception &e) {
+    std::cerr << "!!! " << e.what() << std::endl;
+    close(client.handle);
+
+    clients_count->decrement();
+  }
+}
+
+int Worker::listen(struct addrinfo const* address) {
+  int handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+  if (handle == -1)
+    throw SocketCreationError();
+
+  int yes = 1;
+  setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+  if (setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(int)) == -1 ||
+      bind(handle, address->ai_addr, address->ai_addrlen) == -1 ||
+      ::listen(handle, SOMAXCONN) == -1) {
+    close(handle);
+    throw PortInUseError();
+  }
+
+  Poller::set_blocking(handle, false);
+  listener = handle;
+  poller.add(listener, &listener);
+
+  return listener;
+}
+
+void Worker::pin(int cpu) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpus);
+#endif
+}
+
+void Worker::accept_clients() {
+  // edge triggered - accept until there is nobody waiting
+  while (true) {
+    Request::client client;
+    socklen_t addr_size = sizeof(client.address);
+    client.handle = accept(listener, (struct sockaddr *)&(client.address), &addr_size);
+
+    if (client.handle == -1) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        std::cerr << "!!! " << ServerError().what() << ": " << strerror(errno) << std::endl;
+      return;
+    }
+
+    clients_count->increment();
+    adopt(client);
+  }
+}
+
+void Worker::steal() {
+  auto& workers = *siblings.load(std::memory_order_relaxed);
+  Request::client client;
+
+  // take half of what waits behind busy sibling, starting with
+  // clients waiting longest - they are at head of its queue, which
+  // is the only end Ring pops from, and they are the ones whose
+  // latency suffers most when sibling is stuck on slow request
+  for (size_t i = 1; i < workers.size(); i++) {
+    Worker& victim = *workers[(id + i) % workers.size()];
+
+    if (!victim.is_busy())
+      continue;
+
+    size_t count = (victim.clients_queue.size() + 1) / 2;
+
+    while (count-- > 0 && victim.clients_queue.pop(client)) {
+      victim.clients_count->decrement();
+      clients_count->increment();
+
+      adopt(client);
+    }
+  }
+}
+
+void Worker::process(Connection* connection, int events) {
+  // it could have been released earlier in this round
+  if (connections.find(connection) == connections.end())
+    return;
+
+  if (events & (Poller::READ | Poller::CLOSED))
+    connection->receive();
+
+  connection->pump();
+
+  // serve every request already buffered, unless client
+  // does not read responses fast enough
+  busy.store(true, std::memory_order_relaxed);
+
+  // clients queued meanwhile would wait for this request,
+  // let some sleeping sibling take them
+  auto workers = siblings.load(std::memory_order_relaxed);
+  if (workers != nullptr && !clients_queue.empty()) {
+    for (auto& sibling : *workers)
+      if (sibling.get() != this && sibling->nudge())
+        break;
+  }
+
+  bool flushed;
+  do {
+    while (connection->state == Connection::State::READING &&
+           connection->has_request() && !connection->is_congested()) {
+      handle(connection);
+
+      if (connection->state == Connection::State::DETACHED) {
+        busy.store(false, std::memory_order_relaxed);
+        release(connection);
+        return;
+      }
+    }
+
+    // poller is edge triggered - requests left buffered when flush
+    // relieves congestion would not be signalled again
+    flushed = connection->flush();
+  } while (connection->state == Connection::State::READING &&
+           !connection->is_congested() && connection->has_request());
+
+  busy.store(false, std::memory_order_relaxed);
+
+  if (connection->state == Connection::State::STREAMING)
+    streaming.insert(connection);
+  else
+    streaming.erase(connection);
+
+  if (flushed && connection->state == Connection::State::WRITING) {
+    connection->linger();
+    release(connection);
+    return;
+  }
+
+  if (connection->is_finished())
+    release(connection);
+}
+
+void Worker::handle(Connection* connection) {
+  // make request
+  Request::shared request = Request::make(connection, &arena);
+
+  Response::shared response = arena.share(new (arena.allocate(sizeof(Response))) Response(request));
+  response->head = &head;
+  response->compressor = &compressor;
+  response->headers[Header::SERVER] = server_header + ", waiting " + std::to_string(clients_count->get());
+
+  try {
+    // std::cout << "Request '" << request->path << "' - worker #"<<id<<", handle #"<<request->handle<<"\n";
+
+    make_action(request, response);
+
+    response->send();
+
+  } catch (HTTP::Error &e) {
+    // error document is built in arena too
+    Arena::Scope scope(&arena);
+    Response::shared error_response = arena.share(new (arena.allocate(sizeof(Response))) Response(request, e));
+    error_response->head = &head;
+    error_response->compressor = &compressor;
+    error_response->headers.insert(response->headers.begin(), response->headers.end());
+    error_response->send();
+  }
+
+  clients_count->record(std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::high_resolution_clock::now() - request->time).count());
+}
+
+void Worker::release(Connection* connection) {
+  connections.erase(connection);
+  streaming.erase(connection);
+  released.push_back(connection);
+}
+
 void Worker::make_action(Request::shared request, Response::shared response) {
-  std::shared_ptr<Service> service = Router::find(request, id);
+  Router::Route const* route = Router::route(*request);
 
-  if (service == nullptr)
+  if (route == nullptr)
     throw HTTP::NotFound();
 
+  // one instance shared by all workers
+  if (route->stateless) {
+    route->stateless->handle(*request, *response);
+    return;
+  }
+
+  if (route->services.empty())
+    throw HTTP::NotFound();
+
+  std::shared_ptr<Service> service = route->services[id];
+
   service->request = request;
   service->response = response;
 
   service->make_action();
 }
 
+bool Worker::push(Request::client const& client) {
+  if (!clients_queue.push(client))
+    return false;
+
+  // only sleeping worker needs a (syscall) wakeup
+  nudge();
+  return true;
+}
+
+void Worker::share(std::vector< std::shared_ptr<Worker> > const* s) {
+  siblings = s;
+}
+
+bool Worker::nudge() {
+  if (!sleeping.exchange(false))
+    return false;
+
+  poller.wake();
+  return true;
+}
+
+void Worker::wake() {
+  poller.wake();
+}
+
 void Worker::stop() {
   should_run = false;
-  for (auto& s : streamers)
-    s.join();
-  streamers.clear();
-  clients_queue_ready.notify_one();
+  wake();
   thread.join();
 }
 
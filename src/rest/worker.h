@@ -1,15 +1,18 @@
 #ifndef REST_CPP_WORKER_H
 #define REST_CPP_WORKER_H
 
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <unordered_set>
+#include <netdb.h>
 
 #include "exceptions.h"
 #include "response.h"
 #include "request.h"
+#include "poller.h"
+#include "ring.h"
+#include "load.h"
+#include "arena.h"
 #include "json/json.h"
 
 #include <pthread.h>
@@ -23,7 +26,9 @@ namespace REST {
 
 /**
  * Worker is single operating thread. Worker can process only
- * one request at a time.
+ * one request at a time, but it polls all of its connections
+ * and reads and writes them without blocking, so slow client
+ * does not stall other ones.
  *
  * @private
  * @see Dispatcher
@@ -31,30 +36,77 @@ namespace REST {
 class Worker final {
 
   public:
-    Worker(int id, int sc, size_t* clients_count);
+    Worker(int id, Load* clients_count);
 
     void make_action(Request::shared request, Response::shared response);
 
     void stop();
+    void wake();
 
-    static int POOL_SIZE;
+    //! hands client over to worker, false if its queue is full
+    bool push(Request::client const& client);
+
+    /**
+     * Lets worker take queued clients from its busy siblings
+     * whenever it has nothing to do.
+     */
+    void share(std::vector< std::shared_ptr<Worker> > const* siblings);
+
+    /**
+     * Opens worker's own listening socket (with SO_REUSEPORT, so
+     * every worker may bind the same address) and accepts clients
+     * on it directly. Returns its handle.
+     */
+    int listen(struct addrinfo const* address);
+
+    //! keeps worker thread on given CPU (Linux only)
+    void pin(int cpu);
+
+    //! wakes worker up if it is sleeping, returns whether it did
+    bool nudge();
+    bool is_busy() const { return busy.load(std::memory_order_relaxed); }
+    bool is_sleeping() const { return sleeping.load(std::memory_order_relaxed); }
+
+    static size_t QUEUE_SIZE;
 
-    std::queue<Request::client> clients_queue;
-    std::mutex clients_queue_lock;
-    std::condition_variable clients_queue_ready;
   private:
     // Json::FastWriter json_writer;
     void run();
+    void adopt();
+    void adopt(Request::client const& client);
+    void steal();
+    void accept_clients();
+    void process(Connection* connection, int events);
+    void handle(Connection* connection);
+    void release(Connection* connection);
     std::string server_header;
+    //! response heads are built here, so its memory is reused
+    std::string head;
+    //! requests and responses are allocated here
+    Arena arena;
+    Compressor compressor;
+
+    Ring<Request::client> clients_queue;
+    //! set while worker waits in poller, only then it needs wakeup
+    std::atomic<bool> sleeping;
+    //! set while worker handles requests
+    std::atomic<bool> busy;
+    std::atomic< std::vector< std::shared_ptr<Worker> > const* > siblings;
+
+    int listener = -1;
+
+    Poller poller;
+    std::unordered_set<Connection*> connections;
+    //! connections written by asynchronous streamers
+    std::unordered_set<Connection*> streaming;
+    std::vector<Connection*> released;
 
     int id;
     bool should_run;
 
-    unsigned int streamers_count;
-    size_t* clients_count;
+    Load* clients_count;
 
     std::thread thread;
-    std::vector<std::thread> streamers;
 };
 
 }
@@ -0,0 +1,181 @@
+#include "writer.h"
+#include "connection.h"
+#include "poller.h"
+
+#include <cstdio>
+
+namespace REST {
+
+const size_t Writer::CHUNK_SIZE = 16384;
+const size_t Writer::MAX_PENDING = 1 << 20;
+
+Writer::Writer(Connection* c, bool ch, bool ka) : connection(c), chunked(ch), keep_alive(ka) {
+  buffer.reserve(CHUNK_SIZE);
+}
+
+Writer::~Writer() {
+}
+
+void Writer::compress(Compressor::Encoding encoding, Compressor* c) {
+  if (c == nullptr) {
+    own_compressor.reset(new Compressor());
+    c = own_compressor.get();
+  }
+
+  if (c->begin(encoding))
+    compressor = c;
+}
+
+bool Writer::write(const char* data, size_t size) {
+  if (ended || !is_open())
+    return false;
+
+  buffer.append(data, size);
+
+  if (buffer.size() < CHUNK_SIZE)
+    return true;
+
+  return send(Compressor::Flush::NONE);
+}
+
+bool Writer::flush() {
+  if (ended || !is_open())
+    return false;
+
+  return send(Compressor::Flush::SYNC);
+}
+
+void Writer::end() {
+  if (ended)
+    return;
+
+  if (is_open())
+    send(Compressor::Flush::FINISH);
+  ended = true;
+
+  if (!asynchronous) {
+    if (!keep_alive)
+      connection->finish();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  poller->wake();
+}
+
+void Writer::abort() {
+  ended = true;
+  keep_alive = false;
+
+  if (!asynchronous) {
+    connection->finish();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  poller->wake();
+}
+
+bool Writer::is_open() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return !closed;
+}
+
+bool Writer::send(Compressor::Flush mode) {
+  std::string* body = &buffer;
+
+  if (compressor != nullptr) {
+    if (!compressor->update(buffer.data(), buffer.size(), compressed, mode))
+      return false;
+    buffer.clear();
+    body = &compressed;
+
+    // compressor keeps small input until it has enough of it
+    if (mode == Compressor::Flush::NONE && compressed.size() < CHUNK_SIZE)
+      return true;
+  }
+
+  std::string chunk;
+
+  if (!body->empty()) {
+    if (chunked) {
+      char size[20];
+      int length = snprintf(size, sizeof(size), "%zx\r\n", body->size());
+
+      chunk.reserve(length + body->size() + 7);
+      chunk.append(size, length);
+      chunk += *body;
+      chunk += "\r\n";
+    } else {
+      chunk = std::move(*body);
+    }
+
+    body->clear();
+    body->reserve(CHUNK_SIZE);
+  }
+
+  // last, empty chunk
+  if (mode == Compressor::Flush::FINISH && chunked)
+    chunk += "0\r\n\r\n";
+
+  if (chunk.empty())
+    return true;
+
+  return deliver(std::move(chunk));
+}
+
+bool Writer::deliver(std::string&& chunk) {
+  // synchronous stream runs in Worker, it may write itself
+  if (!asynchronous) {
+    connection->write(nullptr, 0, std::move(chunk));
+
+    if (waits && connection->is_congested() && !connection->wait_flush())
+      closed = true;
+    if (connection->is_closed())
+      closed = true;
+    return !closed;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  drained.wait(lock, [this] () { return pending_size < MAX_PENDING || closed; });
+
+  if (closed)
+    return false;
+
+  // Worker takes chunks when it is woken up, once is enough
+  bool wake = pending.empty();
+  pending_size += chunk.size();
+  pending.push_back(std::move(chunk));
+  lock.unlock();
+
+  if (wake)
+    poller->wake();
+  return true;
+}
+
+bool Writer::drain(Connection* connection) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  while (!pending.empty() && !connection->is_congested()) {
+    pending_size -= pending.front().size();
+    connection->write(nullptr, 0, std::move(pending.front()));
+    pending.pop_front();
+  }
+
+  drained.notify_all();
+  return finished && pending.empty();
+}
+
+void Writer::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  closed = true;
+  drained.notify_all();
+}
+
+}
@@ -0,0 +1,98 @@
+#ifndef REST_CPP_WRITER_H
+#define REST_CPP_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "compressor.h"
+#include "string_view.h"
+
+namespace REST {
+
+class Connection;
+class Poller;
+
+/**
+ * Writer is body of streamed response. Whatever is written is
+ * buffered into chunks of CHUNK_SIZE bytes and sent with HTTP/1.1
+ * chunked transfer encoding, so connection may be kept alive
+ * when stream ends (HTTP/1.0 clients get plain body and connection
+ * is closed instead).
+ *
+ * Writer of synchronous stream writes to connection directly and
+ * waits for socket, when client does not read fast enough (unless
+ * it is told to leave what was not sent for Worker to flush). Writer
+ * of asynchronous one queues chunks for Worker, which owns the
+ * connection, and waits when more than MAX_PENDING bytes are
+ * queued already.
+ *
+ * Writes fail once client is gone.
+ *
+ * @see Response::stream
+ */
+class Writer final {
+  friend class Response;
+  friend class Connection;
+
+  public:
+    typedef std::shared_ptr<Writer> shared;
+
+    const static size_t CHUNK_SIZE;
+    const static size_t MAX_PENDING;
+
+    Writer(Connection* connection, bool chunked, bool keep_alive);
+    ~Writer();
+
+    Writer(Writer const&) = delete;
+    Writer& operator=(Writer const&) = delete;
+
+    bool write(const char* data, size_t size);
+    bool write(StringView const& data) { return write(data.data(), data.size()); }
+    //! sends everything written so far
+    bool flush();
+    //! ends response, called when streamer returns
+    void end();
+
+    bool is_open() const;
+
+  private:
+    //! compresses body, using `compressor` if given or its own one
+    void compress(Compressor::Encoding encoding, Compressor* compressor);
+    //! ends response without its last chunk, connection is closed
+    void abort();
+
+    bool send(Compressor::Flush mode);
+    bool deliver(std::string&& chunk);
+
+    //! moves queued chunks to connection, true when stream ended
+    bool drain(Connection* connection);
+    void close();
+
+    Connection* connection;
+    Poller* poller = nullptr;
+    bool chunked;
+    bool keep_alive;
+    bool ended = false;
+
+    std::string buffer;
+    std::string compressed;
+    Compressor* compressor = nullptr;
+    std::unique_ptr<Compressor> own_compressor;
+
+    mutable std::mutex mutex;
+    std::condition_variable drained;
+    std::deque<std::string> pending;
+    size_t pending_size = 0;
+    bool asynchronous = false;
+    //! synchronous writer waits for socket when connection is congested
+    bool waits = true;
+    bool finished = false;
+    bool closed = false;
+};
+
+}
+
+#endif